@@ -16,10 +16,6 @@
 **       glDrawArrays(GL_TRIANGLES, 0, 6);
 **   }
 **
-** More push/pop macros to add:
-**    glEnableVertexAttribArray/glDisableVertexAttribArray
-**    glActiveTexture() : glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTextureUnit);
-**
 ** Possible improvements:
 ** - There should be an easy way to turn off restoring of states (since that requires expensively querying via glGetInteger, etc.).
 **   Instead, unset the state without restoring the old state (i.e. glUseProgram(0) instead of glUseProgram(old)).
@@ -28,85 +24,521 @@
 **   'scope_' and appending ';'.
 ** - We could add calls to glError() at the end of every scope
 ** - Avoid warning about shadowing variables when putting scope macros on the same line
+**
+** Modes (define before including):
+**   SCOPE_GL_RESTORE_STATE  restore the previous state on exit instead of resetting it to zero/GL_NONE.
+**   SCOPE_GL_SHADOW_STATE   keep a CPU-side copy of all tracked state per GL context and serve the previous value from it
+**                           instead of querying the driver. Works with and without SCOPE_GL_RESTORE_STATE. Needs
+**                           SCOPE_GL_IMPLEMENTATION in exactly one translation unit and a context set up with:
+**
+**                             scope_gl_context_t ctx;         // must outlive the GL context, e.g. in your state struct
+**                             scope_gl_context_sync(&ctx);    // reads all tracked state once, with the GL context current
+**                             scope_gl_make_current(&ctx);
+**
+**                           The current context is per thread (see SCOPE_GL_THREAD_LOCAL), so every GL context gets its own
+**                           scope_gl_context_t and every thread makes the one of its GL context current, e.g. a loader
+**                           thread with a shared upload context. scope_SDL_GL_MakeCurrent() does both in one call.
+**                           All changes to tracked state have to go through the scopes, otherwise the shadow copy goes
+**                           stale. After direct gl* calls use scope_glInvalidate()/scope_glResync() on the groups they touch.
+**                           Pushes and pops that would not change the tracked state skip the gl* call.
+**   SCOPE_GL_STATS          count gl* calls, skipped redundant calls and queries per kind of scope, see scope_gl_stats_t.
+**   SCOPE_GL_DSA            GL 4.5 direct state access: scope_glTextureParameter, scope_glNamedFramebufferTexture,
+**                           scope_glBufferData and scope_glMapBufferRange edit objects without binding them, and state that is applied later
+**                           (lazy mode, state blocks, command buffers) binds textures with glBindTextureUnit instead
+**                           of switching glActiveTexture. Objects have to exist, i.e. come from glCreate* or were bound once.
+**   SCOPE_GL_CHECK_ERRORS   attribute GL errors and leaked scopes to the __FILE__/__LINE__ of the innermost scope.
+**   SCOPE_GL_CAPTURE        record the scopes and draws of N frames into a binary trace for test/replay.c, see scope_gl_capture_t.
+**   SCOPE_GL_NO_REDUNDANCY_CHECK  always issue the gl* call in shadow mode, even if the state is unchanged (for debugging).
+**   SCOPE_GL_LAZY_STATE     implies SCOPE_GL_SHADOW_STATE. Scopes only record the state they want and the difference to what
+**                           the context has is applied by scope_glDrawArrays/scope_glDrawElements or scope_glFlushState().
+**                           Scopes that are left without drawing cost no gl* calls at all. Any other gl* call that depends
+**                           on tracked state (glClear, glBufferData, glTexImage2D, ...) needs a scope_glFlushState() first.
+**                           Draws inside scope_glRecord() can be reordered by state before they are issued, see
+**                           scope_gl_cmdbuf_t.
 */
 
+#ifndef SCOPE_GL_H_
+#define SCOPE_GL_H_
+
+#include <stddef.h> /* NULL in the inline helpers of every mode */
+
 /* api */
-#define scope_glUseProgram(id)                                                   _scope_glUseProgram(id)
-#define scope_glBindVertexArray(vao)                                             _scope_glBindVertexArray(vao)
-#define scope_glBindTexture(target,texture)                                      _scope_glBindTexture(target,texture)
-#define scope_glBindBuffer(target,buffer)                                        _scope_glBindBuffer(target,buffer)
-#define scope_glBindArrayBuffer(vbo)                                             _scope_glBindArrayBuffer(vbo)
-#define scope_glEnable(enumval)                                                  _scope_glEnable(enumval)
-#define scope_glDisable(enumval)                                                 _scope_glDisable(enumval)
-#define scope_glBindFramebuffer(target, fbo)                                     _scope_glBindFramebuffer(target, fbo)                                   /* TODO: untested */
+#define scope_glUseProgram(id)                                                   _scope_gl_capture(USE_PROGRAM, id, 0, 0, 0) _scope_glUseProgram(id)
+#define scope_glBindVertexArray(vao)                                             _scope_gl_capture(BIND_VERTEX_ARRAY, vao, 0, 0, 0) _scope_glBindVertexArray(vao)
+#define scope_glBindTexture(target,texture)                                      _scope_gl_capture(BIND_TEXTURE, target, texture, 0, 0) _scope_glBindTexture(target,texture)
+#define scope_glBindBuffer(target,buffer)                                        _scope_gl_capture(BIND_BUFFER, target, buffer, 0, 0) _scope_glBindBuffer(target,buffer)
+#define scope_glBindArrayBuffer(vbo)                                             _scope_gl_capture(BIND_BUFFER, GL_ARRAY_BUFFER, vbo, 0, 0) _scope_glBindArrayBuffer(vbo)
+#define scope_glEnable(enumval)                                                  _scope_gl_capture(ENABLE, enumval, 0, 0, 0) _scope_glEnable(enumval)
+#define scope_glDisable(enumval)                                                 _scope_gl_capture(DISABLE, enumval, 0, 0, 0) _scope_glDisable(enumval)
+#define scope_glBindFramebuffer(target, fbo)                                     _scope_gl_capture(BIND_FRAMEBUFFER, target, fbo, 0, 0) _scope_glBindFramebuffer(target, fbo)                                   /* TODO: untested */
 #define scope_glFramebufferTexture(target,attachment,textarget,texture,level)    _scope_glFramebufferTexture(target,attachment,textarget,texture,level)  /* TODO: untested */
 #define scope_glBindRenderbuffer(target,renderbuffer)                            _scope_glBindRenderbuffer(target,renderbuffer)                          /* TODO: untested */
 #define scope_glFramebufferRenderbuffer(fbo,attachment,renderbuffer)             _scope_glFramebufferRenderbuffer(fbo,attachment,renderbuffer)           /* TODO: untested */
-#define scope_glViewport(x,y,w,h)                                                _scope_glViewport(x,y,w,h)
-#define scope_glClearColor(r,g,b,a)                                              _scope_glClearColor(r,g,b,a)
-#define scope_glBlendFunc(src,dst)                                               _scope_glBlendFunc(src,dst)
-#define scope_glBlendEquation(eq)                                                _scope_glBlendEquation(eq)
-#define scope_glCullFace(mode)                                                   _scope_glCullFace(mode)                                                 /* TODO: untested */
-#define scope_glFrontFace(orient)                                                _scope_glFrontFace(orient)                                              /* TODO: untested */
-#define scope_glScissor(x,y,w,h)                                                 _scope_glScissor(x,y,w,h)                                               /* TODO: untested */
+#define scope_glViewport(x,y,w,h)                                                _scope_gl_capture(VIEWPORT, x, y, w, h) _scope_glViewport(x,y,w,h)
+#define scope_glClearColor(r,g,b,a)                                              _scope_gl_capture(CLEAR_COLOR, _scope_gl_float_bits(r), _scope_gl_float_bits(g), _scope_gl_float_bits(b), _scope_gl_float_bits(a)) _scope_glClearColor(r,g,b,a)
+#define scope_glBlendFunc(src,dst)                                               _scope_gl_capture(BLEND_FUNC, src, dst, 0, 0) _scope_glBlendFunc(src,dst)
+#define scope_glBlendEquation(eq)                                                _scope_gl_capture(BLEND_EQUATION, eq, 0, 0, 0) _scope_glBlendEquation(eq)
+#define scope_glCullFace(mode)                                                   _scope_gl_capture(CULL_FACE, mode, 0, 0, 0) _scope_glCullFace(mode)                                                 /* TODO: untested */
+#define scope_glFrontFace(orient)                                                _scope_gl_capture(FRONT_FACE, orient, 0, 0, 0) _scope_glFrontFace(orient)                                              /* TODO: untested */
+#define scope_glScissor(x,y,w,h)                                                 _scope_gl_capture(SCISSOR, x, y, w, h) _scope_glScissor(x,y,w,h)                                               /* TODO: untested */
+#define scope_glBindSampler(unit,sampler)                                        _scope_gl_capture(BIND_SAMPLER, unit, sampler, 0, 0) _scope_glBindSampler(unit,sampler)
+#define scope_glActiveTexture(texture)                                           _scope_gl_capture(ACTIVE_TEXTURE, texture, 0, 0, 0) _scope_glActiveTexture(texture)
+#define scope_glVertexAttribMask(mask)                                           _scope_gl_capture(VERTEX_ATTRIB_MASK, mask, 0, 0, 0) _scope_glVertexAttribMask(mask) /* bit i enables attribute i of the bound vertex array */
+
+/* multi-bind (GL 4.4), the previous bindings are saved in one array of up to SCOPE_GL_MAX_MULTI_BIND entries, larger counts
+ * are clamped (reported with SCOPE_GL_CHECK_ERRORS) */
+#define scope_glBindTextures(first,count,ids)                                    _scope_glBindTextures(first,count,ids) /* NOTE: GL_TEXTURE_2D textures, checked with SCOPE_GL_CHECK_ERRORS */
+#define scope_glBindSamplers(first,count,ids)                                    _scope_glBindSamplers(first,count,ids)
+#define scope_glBindBuffersBase(target,first,count,ids)                          _scope_glBindBuffersBase(target,first,count,ids)
+
+/* viewport arrays (GL 4.1), count {x, y, w, h} rects for the indices first .. first + count - 1 (clamped to SCOPE_GL_MAX_VIEWPORTS),
+ * GLfloat for viewports and GLint for scissor boxes. Without SCOPE_GL_RESTORE_STATE indices above 0 are reset to index 0.
+ * NOTE: scope_glViewport/scope_glScissor set every index, like the gl* calls */
+#define scope_glViewportArray(first,count,rects)                                 _scope_glViewportArray(first,count,rects)
+#define scope_glScissorArray(first,count,rects)                                  _scope_glScissorArray(first,count,rects)
 
 /* convenience macros with simpler api */
-#define scope_glBindTexture2D(tex_id)                                            _scope_glBindTexture2D(tex_id)
-#define scope_glBindFBO(fbo)                                                     _scope_glBindFBO(fbo)
+#define scope_glBindTexture2D(tex_id)                                            _scope_gl_capture(BIND_TEXTURE, GL_TEXTURE_2D, tex_id, 0, 0) _scope_glBindTexture2D(tex_id)
+#define scope_glBindFBO(fbo)                                                     _scope_gl_capture(BIND_FRAMEBUFFER, GL_FRAMEBUFFER, fbo, 0, 0) _scope_glBindFBO(fbo)
 #define scope_glFramebufferTex2D(attachment,tex)                                 _scope_glFramebufferTex2D(attachment,tex)
 #define scope_glBindSSBO(ssbo, binding)                                          _scope_glBindSSBO(ssbo, binding)
+#define scope_glPixelUnpackBuffer(pbo)                                           _scope_glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo)
 #define scope_glTex2DParameter(ext,param,val)                                    _scope_glTex2DParameter(ext,param,val)
+#define scope_glSampler(unit,...)                                                _scope_glSampler(unit,__VA_ARGS__) /* pname/value pairs, see scope_gl_samplers_t */
+#define scope_glRenderTarget(...)                                                _scope_glRenderTarget(__VA_ARGS__) /* attachment/texture pairs, see scope_gl_framebuffers_t */
 
+/* edit a named object for the scope, with SCOPE_GL_DSA without binding it (scope_glBufferData is a plain statement) */
+#define scope_glTextureParameter(texture,ext,param,val)                          _scope_glTextureParameter(texture,ext,param,val) /* NOTE: GL_TEXTURE_2D without DSA */
+#define scope_glNamedFramebufferTexture(fbo,attachment,texture,level)            _scope_glNamedFramebufferTexture(fbo,attachment,texture,level)
+#define scope_glBufferData(buffer,size,data,usage)                               _scope_gl_buffer_data(buffer,size,data,usage)
+#define scope_glMapBufferRange(buffer,offset,length,access,ptr)                  _scope_glMapBufferRange(buffer,offset,length,access,ptr) /* declares void* ptr, NULL if mapping failed */
 
+/* prebuilt set of state applied as a whole, see scope_gl_state_block_t (shadow mode only) */
+#define scope_glStateBlock(block)                                                _shadow_glStateBlock(block)
 
-#ifdef SCOPE_GL_RESTORE_STATE
-#define _scope_glUseProgram(id)                                                  _restore_glUseProgram(id)
-#define _scope_glBindVertexArray(vao)                                            _restore_glBindVertexArray(vao)
-#define _scope_glBindTexture(target,texture)                                     _restore_glBindTexture(target,texture)
-#define _scope_glBindBuffer(target,buffer)                                       _restore_glBindBuffer(target,buffer)
-#define _scope_glBindArrayBuffer(vbo)                                            _restore_glBindArrayBuffer(vbo)
-#define _scope_glEnable(enumval)                                                 _restore_glEnable(enumval)
-#define _scope_glDisable(enumval)                                                _restore_glDisable(enumval)
-#define _scope_glBindFramebuffer(target, fbo)                                    _restore_glBindFramebuffer(target, fbo)
-#define _scope_glFramebufferTexture(target,attachment,textarget,texture,level)   _restore_glFramebufferTexture(target,attachment,textarget,texture,level)
-#define _scope_glBindRenderbuffer(target,renderbuffer)                           _restore_glBindRenderbuffer(target,renderbuffer)
-#define _scope_glFramebufferRenderbuffer(fbo,attachment,renderbuffer)            _restore_glFramebufferRenderbuffer(fbo,attachment,renderbuffer)
-#define _scope_glViewport(x,y,w,h)                                               _restore_glViewport(x,y,w,h)
-#define _scope_glClearColor(r,g,b,a)                                             _restore_glClearColor(r,g,b,a)
-#define _scope_glBlendFunc(src,dst)                                              _restore_glBlendFunc(src,dst)
-#define _scope_glBlendEquation(eq)                                               _restore_glBlendEquation(eq)
-#define _scope_glCullFace(mode)                                                  _restore_glCullFace(mode)
-#define _scope_glFrontFace(orient)                                               _restore_glFrontFace(orient)
-#define _scope_glScissor(x,y,w,h)                                                _restore_glScissor(x,y,w,h)
-#define _scope_glBindTexture2D(tex_id)                                           _restore_glBindTexture2D(tex_id)
-#define _scope_glBindFBO(fbo)                                                    _restore_glBindFBO(fbo)
-#define _scope_glFramebufferTex2D(attachment,tex)                                _restore_glFramebufferTex2D(attachment,tex)
-#define _scope_glBindSSBO(ssbo, binding)                                         _restore_glBindSSBO(ssbo, binding)
-#define _scope_glTex2DParameter(ext,param,val)                                   _restore_glTex2DParameter(ext,param,val)
+/* draw calls, in lazy mode these apply the recorded state first (or are recorded inside scope_glRecord) */
+#define scope_glFlushState()                                                     _scope_gl_flush(SCOPE_GL_STATE_ALL)
+#define scope_glDrawArrays(mode,first,count)                                     (_scope_gl_capture_draw(DRAW_ARRAYS, mode, first, count, 0), _scope_gl_draw(_scope_gl_record(_SCOPE_GL_CMD_DRAW_ARRAYS, mode, first, count, 0, NULL), glDrawArrays(mode,first,count)))
+#define scope_glDrawElements(mode,count,type,indices)                            (_scope_gl_capture_draw(DRAW_ELEMENTS, mode, count, type, (uintptr_t) (indices)), _scope_gl_draw(_scope_gl_record(_SCOPE_GL_CMD_DRAW_ELEMENTS, mode, 0, count, type, indices), glDrawElements(mode,count,type,indices)))
+#define scope_glClear(mask)                                                      (_scope_gl_capture_draw(CLEAR, mask, 0, 0, 0), _scope_gl_draw(_scope_gl_record(_SCOPE_GL_CMD_CLEAR, mask, 0, 0, 0, NULL), glClear(mask)))
+
+/* after foreign code (UI libraries, video decoders, ...) changed tracked state behind the scopes: forget the SCOPE_GL_STATE_*
+ * groups in mask until their next use, or query them right away in one sweep (shadow mode only, no-ops otherwise) */
+#define scope_glInvalidate(mask)                                                 _scope_gl_invalidate(mask)
+#define scope_glResync(mask)                                                     _scope_gl_resync(mask)
+
+/* draws inside are recorded into a command buffer and issued sorted by state on submit, see scope_gl_cmdbuf_t (lazy mode only) */
+#define scope_glRecord(cmdbuf)                                                   _lazy_glRecord(cmdbuf)
+/* draws inside under the same state are issued as one multi-draw-indirect, see scope_gl_batch_t (lazy mode only) */
+#define scope_glDrawBatch(batch)                                                 _lazy_glDrawBatch(batch)
+
+/* uniform block data copied into the current buffer ring and bound as a range for the scope, see scope_gl_ring_t */
+#define scope_glUniformBlock(binding,ptr,size)                                   _scope_glUniformBlock(binding,ptr,size)
+#define scope_glBindlessTextures(binding,first,count,textures)                   _scope_glBindlessTextures(binding,first,count,textures) /* see scope_gl_residency_t */
+
+/* GPU time of the scope, read back a few frames later, see scope_gl_timers_t */
+#define scope_glTimer(name)                                                      _scope_glTimer(name)
+
+/* for pushing and popping uniform values of the current program (always restored, name has to be a string literal) */
+#define scope_glUniformMatrix4fv(matrix,name)                                    _scope_glUniformMatrix4fv(matrix,name)
+#define scope_glUniformfv(val,name)                                              _scope_glUniformfv(val,name)
+#define scope_glUniform1i(val,name)                                              _scope_glUniform1i(val,name)
+#define scope_glUniform2fv(vec,name)                                             _scope_glUniformv1(2f,vec,name)
+#define scope_glUniform3fv(vec,name)                                             _scope_glUniformv1(3f,vec,name)
+#define scope_glUniform4fv(vec,name)                                             _scope_glUniformv1(4f,vec,name)
+#define scope_glUniformv(ext,values,count,name)                                  _scope_glUniformv(ext,values,count,name) /* NOTE: shadow mode only */
+// ext = {1f,2f,3f,4f,1i,2i,3i,4i,Matrix3f,Matrix4f}, for arrays name is the first element, e.g. "lights[0]"
+
+
+
+#if defined(SCOPE_GL_LAZY_STATE) && !defined(SCOPE_GL_SHADOW_STATE)
+#define SCOPE_GL_SHADOW_STATE /* lazy mode is built on top of the shadow copy */
+#endif
+
+/* NOTE: define SCOPE_GL_THREAD_LOCAL empty if only one thread ever uses the scopes */
+#ifndef SCOPE_GL_THREAD_LOCAL
+  #if defined(__cplusplus) && __cplusplus >= 201103L
+    #define SCOPE_GL_THREAD_LOCAL thread_local
+  #elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+    #define SCOPE_GL_THREAD_LOCAL _Thread_local
+  #elif defined(_MSC_VER)
+    #define SCOPE_GL_THREAD_LOCAL __declspec(thread)
+  #else
+    #define SCOPE_GL_THREAD_LOCAL __thread
+  #endif
+#endif
+
+/*
+** SCOPE_GL_STATS: counts per thread and per kind of scope how many state changing gl* calls were issued, how many
+** redundant ones were skipped (shadow mode) and how many glGet* and glIsEnabled queries were made, plus the scope nesting
+** depth. Needs SCOPE_GL_IMPLEMENTATION in one translation unit, scope_gl_context_sync() is not counted. Per frame:
+**
+**   scope_gl_stats_t stats = scope_gl_stats_snapshot();
+**   scope_gl_stats_reset();
+**   for (int k = 0; k < SCOPE_GL_STAT_COUNT; k++) printf("%s: %u sets\n", scope_gl_stat_names[k], stats.sets[k]);
+**
+** Without the define all of it compiles to nothing.
+*/
+/* NOTE: same order as the SCOPE_GL_STATE_* groups, so a group bit maps to its kind */
+#define _SCOPE_GL_STAT_KINDS(X)                                                                      \
+        X(PROGRAM)        X(VERTEX_ARRAY)   X(TEXTURES)       X(BUFFERS)        X(SSBO)             \
+        X(FRAMEBUFFER)    X(RENDERBUFFER)   X(CAPS)           X(VIEWPORT)       X(SCISSOR)          \
+        X(CLEAR_COLOR)    X(BLEND_FUNC)     X(BLEND_EQUATION) X(CULL_FACE)      X(FRONT_FACE)       \
+        X(SAMPLERS)       X(UNIFORMS)       X(VERTEX_ATTRIBS) X(TEX_PARAMETERS)
+
+/*
+** SCOPE_GL_CHECK_ERRORS: every scope tags its __FILE__/__LINE__ into a small per-thread ring, so GL errors can be
+** attributed to the innermost scope without a glGetError() per scope (which serializes the pipeline). Meant for
+** debug and QA builds, needs SCOPE_GL_IMPLEMENTATION in one translation unit. Errors are collected either way:
+**
+**   glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);                  // KHR_debug: the callback runs inside the failing call,
+**   glDebugMessageCallback(scope_gl_debug_callback, NULL);  // or call scope_gl_error_site() from your own callback
+**
+**   scope_gl_errors_frame();                                // once per frame outside of all scopes: one glGetError sweep
+**
+** and reported to the handler of scope_gl_set_error_handler() (default prints to stderr). A sweep can't tell which
+** call failed, it names the innermost scope open at the sweep or else the last one entered, call it per pass to
+** narrow it down. scope_gl_errors_frame() also reports scopes that were never left (return or goto out of a scope
+** skips its pop and leaks the state, a break only skips the innermost pop and goes unnoticed). Misuse the scopes
+** catch themselves (counts past their arrays, ...) is reported the same way as GL_INVALID_VALUE.
+*/
+#ifdef SCOPE_GL_CHECK_ERRORS
+#ifndef SCOPE_GL_ERROR_RING
+#define SCOPE_GL_ERROR_RING 32 /* power of two, scopes nested deeper overwrite the outer ones */
+#endif
+
+typedef struct scope_gl_site_t {
+    const char* file;
+    int         line;
+    int         kind;                                                        /* SCOPE_GL_STAT_* */
+} scope_gl_site_t;
+
+typedef struct scope_gl_error_scopes_t {
+    scope_gl_site_t ring[SCOPE_GL_ERROR_RING];                               /* indexed by nesting depth */
+    scope_gl_site_t last;                                                    /* scope entered last */
+    GLuint          depth;                                                   /* scopes currently entered */
+} scope_gl_error_scopes_t;
+
+/* error: glGetError() value, KHR_debug message id or GL_NO_ERROR for a leaked scope, site: NULL before the first scope */
+typedef void (*scope_gl_error_handler_t)(GLenum error, const char* message, const scope_gl_site_t* site, void* user);
+
+extern SCOPE_GL_THREAD_LOCAL scope_gl_error_scopes_t _scope_gl_error_scopes;
+void scope_gl_set_error_handler(scope_gl_error_handler_t handler, void* user);
+GLuint scope_gl_errors_frame(void); /* returns the number of errors and leaks reported */
+void GLAPIENTRY scope_gl_debug_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                                        const GLchar* message, const void* user);
+
+/* innermost scope entered right now, or the last one entered if there is none */
+static inline const scope_gl_site_t* scope_gl_error_site(void) {
+    scope_gl_error_scopes_t* e = &_scope_gl_error_scopes;
+    if (e->depth > 0) { return &e->ring[(e->depth - 1) & (SCOPE_GL_ERROR_RING - 1)]; }
+    return e->last.file ? &e->last : NULL;
+}
+
+void _scope_gl_usage_error(const char* message);
+#define _scope_gl_check(cond, message) ((cond) || (_scope_gl_usage_error(message), 0))
+#else
+#define _scope_gl_check(cond, message) (cond)
+#endif
+
+/*
+** SCOPE_GL_CAPTURE: the scopes with plain arguments (binds, caps, viewport, blend, ...) and scope_glDrawArrays/
+** scope_glDrawElements/scope_glClear append an event with their arguments, __FILE__/__LINE__ and a timestamp to the
+** capture of their thread. test/replay.c runs a trace against a fresh GL context in every mode and reports gl* calls
+** and CPU time, so a scene from production becomes a repeatable benchmark:
+**
+**   static char memory[4 << 20];
+**   scope_gl_capture_t capture;
+**   scope_gl_capture_init(&capture, memory, sizeof(memory), 100); // the next 100 frames
+**   scope_gl_capture_make_current(&capture);
+**   ...
+**   scope_gl_capture_frame(&capture);                             // once per frame outside of all scopes
+**
+**   while (scope_gl_capture_drain(&capture, file)) { sleep_ms(10); } // any one thread, e.g. a writer thread
+**
+** The memory is split into SCOPE_GL_CAPTURE_CHUNKS chunks. Full chunks (and the current one at the end of a frame) are
+** handed to scope_gl_capture_drain() without locks; while all of them wait for the drain the rest of the frame is dropped
+** (counted in 'dropped') instead of blocking it, the replay leaves the scopes still open at the end of the frame.
+** Give every thread that uses scopes its own capture and file.
+** NOTE: uniform, multi-bind, cache and ring scopes and direct gl* calls are not captured, object names are recorded
+** as they are and the replay makes up objects for them.
+**
+** Trace format, little endian 32-bit words: "SGLT", version, then events of { op | site << 16, ns since the previous
+** event, args[] }. SCOPE_GL_OP_SITE events name a site before its first use: line as time, then the length of the
+** file name in bytes and the name padded to words.
+*/
+#define _SCOPE_GL_CAPTURE_OPS(X)                                                                         \
+        X(POP, 0)               X(FRAME, 0)             X(SITE, 0)              X(DRAW_ARRAYS, 3)       \
+        X(DRAW_ELEMENTS, 4)     X(CLEAR, 1)             X(USE_PROGRAM, 1)       X(BIND_VERTEX_ARRAY, 1) \
+        X(BIND_TEXTURE, 2)      X(BIND_BUFFER, 2)       X(ENABLE, 1)            X(DISABLE, 1)           \
+        X(BIND_FRAMEBUFFER, 2)  X(VIEWPORT, 4)          X(SCISSOR, 4)           X(CLEAR_COLOR, 4)       \
+        X(BLEND_FUNC, 2)        X(BLEND_EQUATION, 1)    X(CULL_FACE, 1)         X(FRONT_FACE, 1)        \
+        X(BIND_SAMPLER, 2)      X(ACTIVE_TEXTURE, 1)    X(VERTEX_ATTRIB_MASK, 1)
+
+#define _SCOPE_GL_OP_ENUM(op, args) SCOPE_GL_OP_##op,
+#define _SCOPE_GL_OP_ARGS(op, args) args,
+enum { _SCOPE_GL_CAPTURE_OPS(_SCOPE_GL_OP_ENUM) SCOPE_GL_OP_COUNT };
+static const unsigned char scope_gl_op_args[] = { _SCOPE_GL_CAPTURE_OPS(_SCOPE_GL_OP_ARGS) }; /* argument words per op */
+
+#ifdef SCOPE_GL_CAPTURE
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* NOTE: the drain may run on another thread, a chunk belongs to it between the release store and its store of 0 */
+#if defined(__cplusplus)
+#include <atomic>
+typedef std::atomic<uint32_t> _scope_gl_atomic_t;
+#define _scope_gl_capture_load(p)     ((p)->load(std::memory_order_acquire))
+#define _scope_gl_capture_store(p, v) ((p)->store((v), std::memory_order_release))
+#elif defined(_MSC_VER)
+#include <intrin.h>
+typedef volatile long _scope_gl_atomic_t; /* NOTE: the read is an _InterlockedOr, _ReadBarrier alone is not enough on ARM64 */
+#define _scope_gl_capture_load(p)     ((uint32_t) _InterlockedOr((p), 0))
+#define _scope_gl_capture_store(p, v) ((void) _InterlockedExchange((p), (long) (v)))
+#else
+#include <stdatomic.h>
+typedef _Atomic uint32_t _scope_gl_atomic_t;
+#define _scope_gl_capture_load(p)     atomic_load_explicit((p), memory_order_acquire)
+#define _scope_gl_capture_store(p, v) atomic_store_explicit((p), (v), memory_order_release)
+#endif
+
+#ifndef SCOPE_GL_CAPTURE_CHUNKS
+#define SCOPE_GL_CAPTURE_CHUNKS 8   /* handed to the drain one at a time */
+#endif
+#ifndef SCOPE_GL_CAPTURE_SITES
+#define SCOPE_GL_CAPTURE_SITES  512 /* power of two, __FILE__/__LINE__ pairs with an id, further ones get site 0 */
+#endif
+
+typedef struct scope_gl_capture_t {
+    uint32_t*          memory;
+    size_t             chunk_words;
+    _scope_gl_atomic_t used[SCOPE_GL_CAPTURE_CHUNKS];                            /* words of a chunk handed to the drain, 0 if free */
+    GLuint             chunk;                                                    /* the one being filled */
+    size_t             head;                                                     /* next free word in it */
+    GLuint             drained;                                                  /* next chunk the drain writes */
+    int                active;
+    int                skipping;                                                 /* dropping events until the end of the frame */
+    _scope_gl_atomic_t done;                                                     /* stopped and the last chunk is handed over */
+    GLuint             frames;                                                   /* left to capture, 0 until scope_gl_capture_stop() */
+    uint64_t           time;                                                     /* of the last event */
+    const char*        site_files[SCOPE_GL_CAPTURE_SITES];                      /* site id is the index + 1 */
+    int                site_lines[SCOPE_GL_CAPTURE_SITES];
+    GLuint             events;
+    GLuint             dropped;
+} scope_gl_capture_t;
+
+extern SCOPE_GL_THREAD_LOCAL scope_gl_capture_t* _scope_gl_capture;
+void scope_gl_capture_init(scope_gl_capture_t* capture, void* memory, size_t size, GLuint frames); /* starts capturing */
+void scope_gl_capture_frame(scope_gl_capture_t* capture);
+void scope_gl_capture_stop(scope_gl_capture_t* capture);
+int scope_gl_capture_drain(scope_gl_capture_t* capture, FILE* file); /* 0 once stopped and everything is written */
+int _scope_gl_capture_event(scope_gl_capture_t* capture, int op, const char* file, int line, const GLuint* args);
+static inline void scope_gl_capture_make_current(scope_gl_capture_t* capture) { _scope_gl_capture = capture; }
+
+static inline GLuint _scope_gl_float_bits(GLfloat f) { GLuint u; memcpy(&u, &f, sizeof(u)); return u; }
+/* 1 if the push was captured, so its pop is too */
+static inline int _scope_gl_capture_push(int op, GLuint a, GLuint b, GLuint c, GLuint d, const char* file, int line) {
+    scope_gl_capture_t* capture = _scope_gl_capture;
+    if (!capture || !capture->active) { return 0; }
+    GLuint args[4] = { a, b, c, d };
+    return _scope_gl_capture_event(capture, op, file, line, args);
+}
+static inline void _scope_gl_capture_pop(int captured) {
+    scope_gl_capture_t* capture = _scope_gl_capture;
+    if (captured && capture && capture->active) { _scope_gl_capture_event(capture, SCOPE_GL_OP_POP, NULL, 0, NULL); }
+}
+#define _scope_gl_capture(op, a, b, c, d) \
+    for (int UQ(cap) = _scope_gl_capture_push(SCOPE_GL_OP_##op, (GLuint) (a), (GLuint) (b), (GLuint) (c), (GLuint) (d), __FILE__, __LINE__); \
+         (UQ(cap) >= 0); UQ(cap) = (_scope_gl_capture_pop(UQ(cap)), -1))
+#define _scope_gl_capture_draw(op, a, b, c, d) ((void) _scope_gl_capture_push(SCOPE_GL_OP_##op, (GLuint) (a), (GLuint) (b), (GLuint) (c), (GLuint) (d), __FILE__, __LINE__))
+#else
+#define _scope_gl_capture(op, a, b, c, d)
+#define _scope_gl_capture_draw(op, a, b, c, d) ((void) 0)
+#endif
+
+#if defined(SCOPE_GL_STATS) || defined(SCOPE_GL_CHECK_ERRORS)
+#include <string.h>
+
+#define _SCOPE_GL_STAT_ENUM(kind) SCOPE_GL_STAT_##kind,
+#define _SCOPE_GL_STAT_NAME(kind) #kind,
+enum { _SCOPE_GL_STAT_KINDS(_SCOPE_GL_STAT_ENUM) SCOPE_GL_STAT_COUNT };
+static const char* const scope_gl_stat_names[] = { _SCOPE_GL_STAT_KINDS(_SCOPE_GL_STAT_NAME) };
+#endif
+
+#ifdef SCOPE_GL_STATS
+typedef struct scope_gl_stats_t {
+    GLuint sets[SCOPE_GL_STAT_COUNT];                                        /* gl* calls that change state */
+    GLuint skipped[SCOPE_GL_STAT_COUNT];                                     /* redundant changes that were not issued */
+    GLuint queries[SCOPE_GL_STAT_COUNT];                                     /* glGet*, glIsEnabled, glGetUniformLocation */
+    GLuint scopes[SCOPE_GL_STAT_COUNT];                                      /* scopes entered */
+    GLuint depth;                                                            /* scopes currently entered */
+    GLuint max_depth;                                                        /* deepest nesting since the last reset */
+} scope_gl_stats_t;
+
+extern SCOPE_GL_THREAD_LOCAL scope_gl_stats_t _scope_gl_stats;
+
+static inline scope_gl_stats_t scope_gl_stats_snapshot(void) { return _scope_gl_stats; }
+static inline void scope_gl_stats_reset(void) {
+    GLuint depth = _scope_gl_stats.depth; /* NOTE: keeps counting scopes that are entered right now */
+    memset(&_scope_gl_stats, 0, sizeof(_scope_gl_stats));
+    _scope_gl_stats.depth = _scope_gl_stats.max_depth = depth;
+}
+#define _scope_gl_stat(field, kind) ((void) (_scope_gl_stats.field[kind] += 1))
+#else
+#define _scope_gl_stat(field, kind) ((void) 0)
+#endif
+
+#if defined(SCOPE_GL_STATS) || defined(SCOPE_GL_CHECK_ERRORS)
+/* queries and sets are what the macro issues by itself, scopes that go through the tracked state count in the setters */
+static inline int _scope_gl_hook_enter(int kind, GLuint queries, GLuint sets, const char* file, int line) {
+#ifdef SCOPE_GL_STATS
+    scope_gl_stats_t* s = &_scope_gl_stats;
+    s->queries[kind] += queries;
+    s->sets[kind]    += sets;
+    s->scopes[kind]  += 1;
+    if (++s->depth > s->max_depth) { s->max_depth = s->depth; }
+#endif
+#ifdef SCOPE_GL_CHECK_ERRORS
+    scope_gl_error_scopes_t* e = &_scope_gl_error_scopes;
+    scope_gl_site_t* site = &e->ring[e->depth++ & (SCOPE_GL_ERROR_RING - 1)];
+    site->file = file;
+    site->line = line;
+    site->kind = kind;
+    e->last    = *site;
+#endif
+    (void) kind; (void) queries; (void) sets; (void) file; (void) line;
+    return 0;
+}
+static inline void _scope_gl_hook_leave(void) {
+#ifdef SCOPE_GL_STATS
+    _scope_gl_stats.depth--;
+#endif
+#ifdef SCOPE_GL_CHECK_ERRORS
+    _scope_gl_error_scopes.depth--;
+#endif
+}
+#define _scope_gl_scope_hook(kind, queries, sets) \
+    for (int UQ(hook) = _scope_gl_hook_enter(SCOPE_GL_STAT_##kind, queries, sets, __FILE__, __LINE__); (UQ(hook) == 0); (UQ(hook) += 1, _scope_gl_hook_leave()))
+#else
+#define _scope_gl_scope_hook(kind, queries, sets)
+#endif
+
+#if defined(SCOPE_GL_SHADOW_STATE)
+#define _scope_glUseProgram(id)                                                  _scope_gl_scope_hook(PROGRAM,        0, 0) _shadow_glUseProgram(id)
+#define _scope_glBindVertexArray(vao)                                            _scope_gl_scope_hook(VERTEX_ARRAY,   0, 0) _shadow_glBindVertexArray(vao)
+#define _scope_glBindTexture(target,texture)                                     _scope_gl_scope_hook(TEXTURES,       0, 0) _shadow_glBindTexture(target,texture)
+#define _scope_glBindBuffer(target,buffer)                                       _scope_gl_scope_hook(BUFFERS,        0, 0) _shadow_glBindBuffer(target,buffer)
+#define _scope_glBindArrayBuffer(vbo)                                            _scope_gl_scope_hook(BUFFERS,        0, 0) _shadow_glBindBuffer(GL_ARRAY_BUFFER,vbo)
+#define _scope_glEnable(enumval)                                                 _scope_gl_scope_hook(CAPS,           0, 0) _shadow_glEnable(enumval)
+#define _scope_glDisable(enumval)                                                _scope_gl_scope_hook(CAPS,           0, 0) _shadow_glDisable(enumval)
+#define _scope_glBindFramebuffer(target, fbo)                                    _scope_gl_scope_hook(FRAMEBUFFER,    0, 0) _shadow_glBindFramebuffer(target, fbo)
+#define _scope_glFramebufferTexture(target,attachment,textarget,texture,level)   _scope_gl_scope_hook(FRAMEBUFFER,    0, 2) _shadow_glFramebufferTexture(target,attachment,textarget,texture,level)
+#define _scope_glBindRenderbuffer(target,renderbuffer)                           _scope_gl_scope_hook(RENDERBUFFER,   0, 0) _shadow_glBindRenderbuffer(target,renderbuffer)
+#define _scope_glFramebufferRenderbuffer(fbo,attachment,renderbuffer)            _scope_gl_scope_hook(FRAMEBUFFER,    0, 2) _shadow_glFramebufferRenderbuffer(fbo,attachment,renderbuffer)
+#define _scope_glViewport(x,y,w,h)                                               _scope_gl_scope_hook(VIEWPORT,       0, 0) _shadow_glViewport(x,y,w,h)
+#define _scope_glClearColor(r,g,b,a)                                             _scope_gl_scope_hook(CLEAR_COLOR,    0, 0) _shadow_glClearColor(r,g,b,a)
+#define _scope_glBlendFunc(src,dst)                                              _scope_gl_scope_hook(BLEND_FUNC,     0, 0) _shadow_glBlendFunc(src,dst)
+#define _scope_glBlendEquation(eq)                                               _scope_gl_scope_hook(BLEND_EQUATION, 0, 0) _shadow_glBlendEquation(eq)
+#define _scope_glCullFace(mode)                                                  _scope_gl_scope_hook(CULL_FACE,      0, 0) _shadow_glCullFace(mode)
+#define _scope_glFrontFace(orient)                                               _scope_gl_scope_hook(FRONT_FACE,     0, 0) _shadow_glFrontFace(orient)
+#define _scope_glScissor(x,y,w,h)                                                _scope_gl_scope_hook(SCISSOR,        0, 0) _shadow_glScissor(x,y,w,h)
+#define _scope_glBindSampler(unit,sampler)                                       _scope_gl_scope_hook(SAMPLERS,       0, 0) _shadow_glBindSampler(unit,sampler)
+#define _scope_glActiveTexture(texture)                                          _scope_gl_scope_hook(TEXTURES,       0, 0) _shadow_glActiveTexture(texture)
+#define _scope_glVertexAttribMask(mask)                                          _scope_gl_scope_hook(VERTEX_ATTRIBS, 0, 0) _shadow_glVertexAttribMask(mask)
+#define _scope_glBindTextures(first,count,ids)                                   _scope_gl_scope_hook(TEXTURES,       0, 0) _shadow_glBindTextures(first,count,ids)
+#define _scope_glBindSamplers(first,count,ids)                                   _scope_gl_scope_hook(SAMPLERS,       0, 0) _shadow_glBindSamplers(first,count,ids)
+#define _scope_glBindBuffersBase(target,first,count,ids)                         _scope_gl_scope_hook(SSBO,           0, 0) _shadow_glBindBuffersBase(target,first,count,ids)
+#define _scope_glViewportArray(first,count,rects)                                _scope_gl_scope_hook(VIEWPORT,       0, 0) _shadow_glViewportArray(first,count,rects)
+#define _scope_glScissorArray(first,count,rects)                                 _scope_gl_scope_hook(SCISSOR,        0, 0) _shadow_glScissorArray(first,count,rects)
+#define _scope_glBindTexture2D(tex_id)                                           _scope_gl_scope_hook(TEXTURES,       0, 0) _shadow_glBindTexture2D(tex_id)
+#define _scope_glBindFBO(fbo)                                                    _scope_gl_scope_hook(FRAMEBUFFER,    0, 0) _shadow_glBindFramebuffer(GL_FRAMEBUFFER,fbo)
+#define _scope_glFramebufferTex2D(attachment,tex)                                _scope_gl_scope_hook(FRAMEBUFFER,    0, 2) _shadow_glFramebufferTex2D(attachment,tex)
+#define _scope_glBindSSBO(ssbo, binding)                                         _scope_gl_scope_hook(SSBO,           0, 0) _shadow_glBindSSBO(ssbo, binding)
+#define _scope_glTex2DParameter(ext,param,val)                                   _scope_gl_scope_hook(TEX_PARAMETERS, 1, 2) _shadow_glTex2DParameter(ext,param,val) // NOTE: texture object state, not shadowed
+#define _scope_glUniformMatrix4fv(matrix,name)                                   _scope_gl_scope_hook(UNIFORMS,       0, 0) _shadow_glUniformv(Matrix4f,matrix,1,name)
+#define _scope_glUniformfv(val,name)                                             _scope_gl_scope_hook(UNIFORMS,       0, 0) _shadow_glUniformfv(val,name)
+#define _scope_glUniform1i(val,name)                                             _scope_gl_scope_hook(UNIFORMS,       0, 0) _shadow_glUniform1i(val,name)
+#define _scope_glUniformv1(ext,values,name)                                      _scope_gl_scope_hook(UNIFORMS,       0, 0) _shadow_glUniformv(ext,values,1,name)
+#define _scope_glUniformv(ext,values,count,name)                                 _scope_gl_scope_hook(UNIFORMS,       0, 0) _shadow_glUniformv(ext,values,count,name)
+#define _scope_glUniformBlock(binding,ptr,size)                                  _scope_gl_scope_hook(UNIFORMS,       0, 0) _ring_glUniformBlock(binding,ptr,size) // NOTE: counts its own calls
+#define _scope_glBindlessTextures(binding,first,count,textures)                  _scope_gl_scope_hook(TEXTURES,       0, 0) _ring_glBindlessTextures(binding,first,count,textures) // NOTE: counts its own calls
+#elif defined(SCOPE_GL_RESTORE_STATE)
+#define _scope_glUseProgram(id)                                                  _scope_gl_scope_hook(PROGRAM,        1, 2) _restore_glUseProgram(id)
+#define _scope_glBindVertexArray(vao)                                            _scope_gl_scope_hook(VERTEX_ARRAY,   1, 2) _restore_glBindVertexArray(vao)
+#define _scope_glBindTexture(target,texture)                                     _scope_gl_scope_hook(TEXTURES,       1, 2) _restore_glBindTexture(target,texture)
+#define _scope_glBindBuffer(target,buffer)                                       _scope_gl_scope_hook(BUFFERS,        1, 2) _restore_glBindBuffer(target,buffer)
+#define _scope_glBindArrayBuffer(vbo)                                            _scope_gl_scope_hook(BUFFERS,        1, 2) _restore_glBindArrayBuffer(vbo)
+#define _scope_glEnable(enumval)                                                 _scope_gl_scope_hook(CAPS,           1, 2) _restore_glEnable(enumval)
+#define _scope_glDisable(enumval)                                                _scope_gl_scope_hook(CAPS,           1, 2) _restore_glDisable(enumval)
+#define _scope_glBindFramebuffer(target, fbo)                                    _scope_gl_scope_hook(FRAMEBUFFER,    1, 2) _restore_glBindFramebuffer(target, fbo)
+#define _scope_glFramebufferTexture(target,attachment,textarget,texture,level)   _scope_gl_scope_hook(FRAMEBUFFER,    0, 2) _restore_glFramebufferTexture(target,attachment,textarget,texture,level)
+#define _scope_glBindRenderbuffer(target,renderbuffer)                           _scope_gl_scope_hook(RENDERBUFFER,   0, 2) _restore_glBindRenderbuffer(target,renderbuffer)
+#define _scope_glFramebufferRenderbuffer(fbo,attachment,renderbuffer)            _scope_gl_scope_hook(FRAMEBUFFER,    0, 2) _restore_glFramebufferRenderbuffer(fbo,attachment,renderbuffer)
+#define _scope_glViewport(x,y,w,h)                                               _scope_gl_scope_hook(VIEWPORT,       1, 2) _restore_glViewport(x,y,w,h)
+#define _scope_glClearColor(r,g,b,a)                                             _scope_gl_scope_hook(CLEAR_COLOR,    1, 2) _restore_glClearColor(r,g,b,a)
+#define _scope_glBlendFunc(src,dst)                                              _scope_gl_scope_hook(BLEND_FUNC,     2, 2) _restore_glBlendFunc(src,dst)
+#define _scope_glBlendEquation(eq)                                               _scope_gl_scope_hook(BLEND_EQUATION, 1, 2) _restore_glBlendEquation(eq)
+#define _scope_glCullFace(mode)                                                  _scope_gl_scope_hook(CULL_FACE,      1, 2) _restore_glCullFace(mode)
+#define _scope_glFrontFace(orient)                                               _scope_gl_scope_hook(FRONT_FACE,     1, 2) _restore_glFrontFace(orient)
+#define _scope_glScissor(x,y,w,h)                                                _scope_gl_scope_hook(SCISSOR,        1, 2) _restore_glScissor(x,y,w,h)
+#define _scope_glBindSampler(unit,sampler)                                       _scope_gl_scope_hook(SAMPLERS,       2, 4) _restore_glBindSampler(unit,sampler)
+#define _scope_glActiveTexture(texture)                                          _scope_gl_scope_hook(TEXTURES,       1, 2) _restore_glActiveTexture(texture)
+#define _scope_glVertexAttribMask(mask)                                          _scope_gl_scope_hook(VERTEX_ATTRIBS, SCOPE_GL_MAX_VERTEX_ATTRIBS, 0) _restore_glVertexAttribMask(mask) // NOTE: toggles count themselves
+#define _scope_glBindTextures(first,count,ids)                                   _scope_gl_scope_hook(TEXTURES, 1 + (count), 3 + (count)) _restore_glBindTextures(first,count,ids)
+#define _scope_glBindSamplers(first,count,ids)                                   _scope_gl_scope_hook(SAMPLERS, 1 + (count), 3 + (count)) _restore_glBindSamplers(first,count,ids)
+#define _scope_glBindBuffersBase(target,first,count,ids)                         _scope_gl_scope_hook(SSBO,     (count),     2) _restore_glBindBuffersBase(target,first,count,ids)
+#define _scope_glViewportArray(first,count,rects)                                _scope_gl_scope_hook(VIEWPORT, (count),     2) _restore_glViewportArray(first,count,rects)
+#define _scope_glScissorArray(first,count,rects)                                 _scope_gl_scope_hook(SCISSOR,  (count),     2) _restore_glScissorArray(first,count,rects)
+#define _scope_glBindTexture2D(tex_id)                                           _scope_gl_scope_hook(TEXTURES,       1, 2) _restore_glBindTexture2D(tex_id)
+#define _scope_glBindFBO(fbo)                                                    _scope_gl_scope_hook(FRAMEBUFFER,    1, 2) _restore_glBindFBO(fbo)
+#define _scope_glFramebufferTex2D(attachment,tex)                                _scope_gl_scope_hook(FRAMEBUFFER,    0, 2) _restore_glFramebufferTex2D(attachment,tex)
+#define _scope_glBindSSBO(ssbo, binding)                                         _scope_gl_scope_hook(SSBO,           1, 4) _restore_glBindSSBO(ssbo, binding)
+#define _scope_glTex2DParameter(ext,param,val)                                   _scope_gl_scope_hook(TEX_PARAMETERS, 1, 2) _restore_glTex2DParameter(ext,param,val)
+#define _scope_glUniformMatrix4fv(matrix,name)                                   _scope_gl_scope_hook(UNIFORMS,       5, 2) _restore_glUniformMatrix4fv(matrix,name)
+#define _scope_glUniformfv(val,name)                                             _scope_gl_scope_hook(UNIFORMS,       5, 2) _restore_glUniformfv(val,name)
+#define _scope_glUniform1i(val,name)                                             _scope_gl_scope_hook(UNIFORMS,       3, 2) _restore_glUniform1i(val,name)
+#define _scope_glUniformv1(ext,values,name)                                      _scope_gl_scope_hook(UNIFORMS,       3, 2) _restore_glUniformv1(ext,values,name)
+#define _scope_glUniformBlock(binding,ptr,size)                                  _scope_gl_scope_hook(UNIFORMS,       0, 0) _ring_glUniformBlock(binding,ptr,size) // NOTE: counts its own calls
+#define _scope_glBindlessTextures(binding,first,count,textures)                  _scope_gl_scope_hook(TEXTURES,       0, 0) _ring_glBindlessTextures(binding,first,count,textures) // NOTE: counts its own calls
 #else // SCOPE_GL_RESTORE_STATE
-#define _scope_glUseProgram(id)                                                  _unset_glUseProgram(id)
-#define _scope_glBindVertexArray(vao)                                            _unset_glBindVertexArray(vao)
-#define _scope_glBindTexture(target,texture)                                     _unset_glBindTexture(target,texture)
-#define _scope_glBindBuffer(target,buffer)                                       _unset_glBindBuffer(target,buffer)
-#define _scope_glBindArrayBuffer(vbo)                                            _unset_glBindArrayBuffer(vbo)
-#define _scope_glEnable(enumval)                                                 _unset_glEnable(enumval)
-#define _scope_glDisable(enumval)                                                _unset_glDisable(enumval)
-#define _scope_glBindFramebuffer(target, fbo)                                    _unset_glBindFramebuffer(target, fbo)
-#define _scope_glFramebufferTexture(target,attachment,textarget,texture,level)   _unset_glFramebufferTexture(target,attachment,textarget,texture,level)
-#define _scope_glBindRenderbuffer(target,renderbuffer)                           _unset_glBindRenderbuffer(target,renderbuffer)
-#define _scope_glFramebufferRenderbuffer(fbo,attachment,renderbuffer)            _unset_glFramebufferRenderbuffer(fbo,attachment,renderbuffer)
-#define _scope_glViewport(x,y,w,h)                                               _unset_glViewport(x,y,w,h)
-#define _scope_glClearColor(r,g,b,a)                                             _unset_glClearColor(r,g,b,a)
-#define _scope_glBlendFunc(src,dst)                                              _unset_glBlendFunc(src,dst)
-#define _scope_glBlendEquation(eq)                                               _unset_glBlendEquation(eq)
-#define _scope_glCullFace(mode)                                                  _unset_glCullFace(mode)
-#define _scope_glFrontFace(orient)                                               _unset_glFrontFace(orient)
-#define _scope_glScissor(x,y,w,h)                                                _unset_glScissor(x,y,w,h)
-#define _scope_glBindTexture2D(tex_id)                                           _unset_glBindTexture2D(tex_id)
-#define _scope_glBindFBO(fbo)                                                    _unset_glBindFBO(fbo)
-#define _scope_glFramebufferTex2D(attachment,tex)                                _unset_glFramebufferTex2D(attachment,tex)
-#define _scope_glBindSSBO(ssbo, binding)                                         _unset_glBindSSBO(ssbo, binding)
-#define _scope_glTex2DParameter(ext,param,val)                                   _restore_glTex2DParameter(ext,param,val) // NOTE: no setting to zero/none possible
+#define _scope_glUseProgram(id)                                                  _scope_gl_scope_hook(PROGRAM,        0, 2) _unset_glUseProgram(id)
+#define _scope_glBindVertexArray(vao)                                            _scope_gl_scope_hook(VERTEX_ARRAY,   0, 2) _unset_glBindVertexArray(vao)
+#define _scope_glBindTexture(target,texture)                                     _scope_gl_scope_hook(TEXTURES,       0, 2) _unset_glBindTexture(target,texture)
+#define _scope_glBindBuffer(target,buffer)                                       _scope_gl_scope_hook(BUFFERS,        0, 2) _unset_glBindBuffer(target,buffer)
+#define _scope_glBindArrayBuffer(vbo)                                            _scope_gl_scope_hook(BUFFERS,        0, 2) _unset_glBindArrayBuffer(vbo)
+#define _scope_glEnable(enumval)                                                 _scope_gl_scope_hook(CAPS,           0, 2) _unset_glEnable(enumval)
+#define _scope_glDisable(enumval)                                                _scope_gl_scope_hook(CAPS,           0, 2) _unset_glDisable(enumval)
+#define _scope_glBindFramebuffer(target, fbo)                                    _scope_gl_scope_hook(FRAMEBUFFER,    0, 2) _unset_glBindFramebuffer(target, fbo)
+#define _scope_glFramebufferTexture(target,attachment,textarget,texture,level)   _scope_gl_scope_hook(FRAMEBUFFER,    0, 2) _unset_glFramebufferTexture(target,attachment,textarget,texture,level)
+#define _scope_glBindRenderbuffer(target,renderbuffer)                           _scope_gl_scope_hook(RENDERBUFFER,   0, 2) _unset_glBindRenderbuffer(target,renderbuffer)
+#define _scope_glFramebufferRenderbuffer(fbo,attachment,renderbuffer)            _scope_gl_scope_hook(FRAMEBUFFER,    0, 2) _unset_glFramebufferRenderbuffer(fbo,attachment,renderbuffer)
+#define _scope_glViewport(x,y,w,h)                                               _scope_gl_scope_hook(VIEWPORT,       0, 2) _unset_glViewport(x,y,w,h)
+#define _scope_glClearColor(r,g,b,a)                                             _scope_gl_scope_hook(CLEAR_COLOR,    0, 2) _unset_glClearColor(r,g,b,a)
+#define _scope_glBlendFunc(src,dst)                                              _scope_gl_scope_hook(BLEND_FUNC,     0, 2) _unset_glBlendFunc(src,dst)
+#define _scope_glBlendEquation(eq)                                               _scope_gl_scope_hook(BLEND_EQUATION, 0, 2) _unset_glBlendEquation(eq)
+#define _scope_glCullFace(mode)                                                  _scope_gl_scope_hook(CULL_FACE,      0, 2) _unset_glCullFace(mode)
+#define _scope_glFrontFace(orient)                                               _scope_gl_scope_hook(FRONT_FACE,     0, 2) _unset_glFrontFace(orient)
+#define _scope_glScissor(x,y,w,h)                                                _scope_gl_scope_hook(SCISSOR,        0, 2) _unset_glScissor(x,y,w,h)
+#define _scope_glBindSampler(unit,sampler)                                       _scope_gl_scope_hook(SAMPLERS,       0, 2) _unset_glBindSampler(unit,sampler)
+#define _scope_glActiveTexture(texture)                                          _scope_gl_scope_hook(TEXTURES,       0, 2) _unset_glActiveTexture(texture)
+#define _scope_glVertexAttribMask(mask)                                          _scope_gl_scope_hook(VERTEX_ATTRIBS, 0, 0) _unset_glVertexAttribMask(mask) // NOTE: toggles count themselves
+#define _scope_glBindTextures(first,count,ids)                                   _scope_gl_scope_hook(TEXTURES,       0, 2) _unset_glBindTextures(first,count,ids)
+#define _scope_glBindSamplers(first,count,ids)                                   _scope_gl_scope_hook(SAMPLERS,       0, 2) _unset_glBindSamplers(first,count,ids)
+#define _scope_glBindBuffersBase(target,first,count,ids)                         _scope_gl_scope_hook(SSBO,           0, 2) _unset_glBindBuffersBase(target,first,count,ids)
+#define _scope_glViewportArray(first,count,rects)                                _scope_gl_scope_hook(VIEWPORT, (first) != 0, 2) _unset_glViewportArray(first,count,rects)
+#define _scope_glScissorArray(first,count,rects)                                 _scope_gl_scope_hook(SCISSOR,  (first) != 0, 2) _unset_glScissorArray(first,count,rects)
+#define _scope_glBindTexture2D(tex_id)                                           _scope_gl_scope_hook(TEXTURES,       0, 2) _unset_glBindTexture2D(tex_id)
+#define _scope_glBindFBO(fbo)                                                    _scope_gl_scope_hook(FRAMEBUFFER,    0, 2) _unset_glBindFBO(fbo)
+#define _scope_glFramebufferTex2D(attachment,tex)                                _scope_gl_scope_hook(FRAMEBUFFER,    0, 2) _unset_glFramebufferTex2D(attachment,tex)
+#define _scope_glBindSSBO(ssbo, binding)                                         _scope_gl_scope_hook(SSBO,           0, 4) _unset_glBindSSBO(ssbo, binding)
+#define _scope_glTex2DParameter(ext,param,val)                                   _scope_gl_scope_hook(TEX_PARAMETERS, 1, 2) _restore_glTex2DParameter(ext,param,val) // NOTE: no setting to zero/none possible
+#define _scope_glUniformMatrix4fv(matrix,name)                                   _scope_gl_scope_hook(UNIFORMS,       5, 2) _restore_glUniformMatrix4fv(matrix,name)
+#define _scope_glUniformfv(val,name)                                             _scope_gl_scope_hook(UNIFORMS,       5, 2) _restore_glUniformfv(val,name)
+#define _scope_glUniform1i(val,name)                                             _scope_gl_scope_hook(UNIFORMS,       3, 2) _restore_glUniform1i(val,name)
+#define _scope_glUniformv1(ext,values,name)                                      _scope_gl_scope_hook(UNIFORMS,       3, 2) _restore_glUniformv1(ext,values,name)
+#define _scope_glUniformBlock(binding,ptr,size)                                  _scope_gl_scope_hook(UNIFORMS,       0, 0) _ring_glUniformBlock(binding,ptr,size) // NOTE: counts its own calls
+#define _scope_glBindlessTextures(binding,first,count,textures)                  _scope_gl_scope_hook(TEXTURES,       0, 0) _ring_glBindlessTextures(binding,first,count,textures) // NOTE: counts its own calls
 #endif // SCOPE_GL_RESTORE_STATE
 
 #define _restore_glUseProgram(id) for (GLint UQ(prog), UQ(i) = (glGetIntegerv(GL_CURRENT_PROGRAM, &UQ(prog)), glUseProgram(id), 0); (UQ(i) == 0); (UQ(i) += 1, glUseProgram(UQ(prog))))
@@ -121,7 +553,7 @@
 #define _restore_glBindTexture2D(tex_id) for (GLint UQ(old_tex), UQ(i) = (glGetIntegerv(GL_TEXTURE_BINDING_2D, &UQ(old_tex)), glBindTexture(GL_TEXTURE_2D, tex_id), 0); (UQ(i) == 0); (UQ(i) += 1, glBindTexture(GL_TEXTURE_2D, UQ(old_tex))))
 #define _unset_glBindTexture2D(tex_id)   scope_begin_end_var(glBindTexture(GL_TEXTURE_2D, tex_id), glBindTexture(GL_TEXTURE_2D, 0), texbind)
 
-#define _restore_glBindBuffer(target,buffer) for (GLint UQ(old_buf), UQ(i) = (glGetIntegerv(GL_BUFFER_BINDING, &UQ(old_buf)), glBindBuffer(target, vbo), 0); (UQ(i) == 0); (UQ(i) += 1, glBindBuffer(target, UQ(old_vbo))))
+#define _restore_glBindBuffer(target,buffer) for (GLint UQ(old_buf), UQ(i) = (glGetIntegerv(_scope_gl_map_buffer_target_to_binding(target), &UQ(old_buf)), glBindBuffer(target, buffer), 0); (UQ(i) == 0); (UQ(i) += 1, glBindBuffer(target, UQ(old_buf))))
 #define _unset_glBindBuffer(target,buffer)   scope_begin_end_var(glBindBuffer(target, buffer), glBindBuffer(target, 0), glbuf)
 
 #define _restore_glBindArrayBuffer(vbo) for (GLint UQ(old_vbo), UQ(i) = (glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &UQ(old_vbo)), glBindBuffer(GL_ARRAY_BUFFER, vbo), 0); (UQ(i) == 0); (UQ(i) += 1, glBindBuffer(GL_ARRAY_BUFFER, UQ(old_vbo))))
@@ -133,7 +565,7 @@
 #define _restore_glDisable(enumval) for (GLint UQ(old_flag), UQ(i) = (glGetBooleanv(enumval, (GLboolean*) &UQ(old_flag)), glDisable(enumval), 0); (UQ(i) == 0); (UQ(i) += 1, (UQ(old_flag) ? glEnable(enumval) : glDisable(enumval))))
 #define _unset_glDisable(enumval)   scope_begin_end_var(glDisable(enumval), glEnable(enumval), glenable)
 
-#define _restore_glBindFramebuffer(target, fbo) for (GLint UQ(old_fbo), UQ(i) = (glGetIntegerv(target, &UQ(old_fbo)), glBindFramebuffer(target, fbo), 0); (UQ(i) == 0); (UQ(i) += 1, glBindFramebuffer(target, UQ(old_fbo))))
+#define _restore_glBindFramebuffer(target, fbo) for (GLint UQ(old_fbo), UQ(i) = (glGetIntegerv((target) == GL_READ_FRAMEBUFFER ? GL_READ_FRAMEBUFFER_BINDING : GL_DRAW_FRAMEBUFFER_BINDING, &UQ(old_fbo)), glBindFramebuffer(target, fbo), 0); (UQ(i) == 0); (UQ(i) += 1, glBindFramebuffer(target, UQ(old_fbo))))
 #define _unset_glBindFramebuffer(target, fbo)   scope_begin_end_var(glBindFramebuffer(target, fbo), glBindFramebuffer(target, 0), old_fbo)
 
 #define _restore_glBindFBO(fbo) for (GLint UQ(old_fbo), UQ(i) = (glGetIntegerv(GL_FRAMEBUFFER_BINDING, &UQ(old_fbo)), glBindFramebuffer(GL_FRAMEBUFFER, fbo), 0); (UQ(i) == 0); (UQ(i) += 1, glBindFramebuffer(GL_FRAMEBUFFER, UQ(old_fbo))))
@@ -155,11 +587,97 @@
 #define _unset_glCullFace(mode)   scope_begin_end_var(glCullFace(mode), glCullFace(0), glcull)
 
 #define _restore_glFrontFace(orient) for (GLint UQ(fo), UQ(i) = (glGetIntegerv(GL_FRONT_FACE, &UQ(fo)), glFrontFace(orient), 0); (UQ(i) == 0); (UQ(i) += 1, glFrontFace(UQ(fo))))
-#define _unset_glFrontFace(orient)   scope_begin_end_var(glFrontface(orient), glFrontFace(0), glfront)
+#define _unset_glFrontFace(orient)   scope_begin_end_var(glFrontFace(orient), glFrontFace(0), glfront)
 
 #define _restore_glScissor(x,y,w,h) for (GLint UQ(old_sci)[4], UQ(i) = (glGetIntegerv(GL_SCISSOR_BOX, UQ(old_sci)), glScissor(x,y,w,h), 0); (UQ(i) == 0); (UQ(i) += 1, glScissor(UQ(old_sci)[0],UQ(old_sci)[1],UQ(old_sci)[2],UQ(old_sci)[3])))
 #define _unset_glScissor(x,y,w,h)   scope_begin_end_var(glScissor(x,y,w,h), glScissor(0,0,1000000000,1000000000), glscissor) // NOTE: will this work or should we only allow restoring?
 
+#define _restore_glBindSampler(unit,sampler) for (GLuint UQ(old_smp) = _scope_gl_query_unit(unit, GL_SAMPLER_BINDING), UQ(i) = (glBindSampler(unit, sampler), 0); (UQ(i) == 0); (UQ(i) += 1, glBindSampler(unit, UQ(old_smp))))
+#define _unset_glBindSampler(unit,sampler)   scope_begin_end_var(glBindSampler(unit, sampler), glBindSampler(unit, 0), smpbind)
+
+#define _restore_glActiveTexture(texture) for (GLint UQ(old_unit), UQ(i) = (glGetIntegerv(GL_ACTIVE_TEXTURE, &UQ(old_unit)), glActiveTexture(texture), 0); (UQ(i) == 0); (UQ(i) += 1, glActiveTexture((GLenum) UQ(old_unit))))
+#define _unset_glActiveTexture(texture)   scope_begin_end_var(glActiveTexture(texture), glActiveTexture(GL_TEXTURE0), actex)
+
+/* NOTE: unset mode only enables the attributes in mask and disables them again, the others are expected to be disabled */
+#define _restore_glVertexAttribMask(mask) \
+    for (GLuint UQ(new_attribs) = (mask), UQ(old_attribs) = _scope_gl_query_vertex_attribs(), UQ(i) = (_scope_gl_toggle_vertex_attribs(UQ(old_attribs) ^ UQ(new_attribs), UQ(new_attribs)), 0); \
+         (UQ(i) == 0); (UQ(i) += 1, _scope_gl_toggle_vertex_attribs(UQ(old_attribs) ^ UQ(new_attribs), UQ(old_attribs))))
+#define _unset_glVertexAttribMask(mask) \
+    for (GLuint UQ(new_attribs) = (mask), UQ(i) = (_scope_gl_toggle_vertex_attribs(UQ(new_attribs), UQ(new_attribs)), 0); (UQ(i) == 0); (UQ(i) += 1, _scope_gl_toggle_vertex_attribs(UQ(new_attribs), 0)))
+
+#ifndef SCOPE_GL_MAX_MULTI_BIND
+#define SCOPE_GL_MAX_MULTI_BIND 16 /* count of a multi-bind scope */
+#endif
+/* larger counts would not fit the array of previous bindings, they are clamped */
+static inline GLsizei _scope_gl_multi_count(GLsizei count) {
+    return _scope_gl_check(count <= SCOPE_GL_MAX_MULTI_BIND, "multi-bind count above SCOPE_GL_MAX_MULTI_BIND, clamped") ? count : SCOPE_GL_MAX_MULTI_BIND;
+}
+/* the previous bindings are the GL_TEXTURE_2D ones, a texture of another target would stay bound after the scope */
+static inline GLsizei _scope_gl_multi_count_2d(GLsizei count, const GLuint* ids) {
+    count = _scope_gl_multi_count(count);
+#ifdef SCOPE_GL_CHECK_ERRORS
+    for (GLsizei i = 0; ids && i < count; i++) {
+        GLint target = GL_TEXTURE_2D;
+        if (ids[i]) { glGetTextureParameteriv(ids[i], GL_TEXTURE_TARGET, &target); } /* GL 4.5 */
+        _scope_gl_check(target == GL_TEXTURE_2D, "scope_glBindTextures with a texture that is not GL_TEXTURE_2D");
+    }
+#else
+    (void) ids;
+#endif
+    return count;
+}
+#define _restore_glBindTextures(first,count,ids) \
+    for (GLuint UQ(old_tex)[SCOPE_GL_MAX_MULTI_BIND], UQ(n) = (GLuint) _scope_gl_multi_count_2d(count, ids), \
+         UQ(i) = (_scope_gl_query_units(first, (GLsizei) UQ(n), GL_TEXTURE_BINDING_2D, UQ(old_tex)), glBindTextures(first, (GLsizei) UQ(n), ids), 0); \
+         (UQ(i) == 0); (UQ(i) += 1, glBindTextures(first, (GLsizei) UQ(n), UQ(old_tex))))
+#define _unset_glBindTextures(first,count,ids) scope_begin_end_var(glBindTextures(first, count, ids), glBindTextures(first, count, NULL), texbinds)
+#define _restore_glBindSamplers(first,count,ids) \
+    for (GLuint UQ(old_smp)[SCOPE_GL_MAX_MULTI_BIND], UQ(n) = (GLuint) _scope_gl_multi_count(count), \
+         UQ(i) = (_scope_gl_query_units(first, (GLsizei) UQ(n), GL_SAMPLER_BINDING, UQ(old_smp)), glBindSamplers(first, (GLsizei) UQ(n), ids), 0); \
+         (UQ(i) == 0); (UQ(i) += 1, glBindSamplers(first, (GLsizei) UQ(n), UQ(old_smp))))
+#define _unset_glBindSamplers(first,count,ids) scope_begin_end_var(glBindSamplers(first, count, ids), glBindSamplers(first, count, NULL), smpbinds)
+#define _restore_glBindBuffersBase(target,first,count,ids) \
+    for (GLuint UQ(old_buf)[SCOPE_GL_MAX_MULTI_BIND], UQ(n) = (GLuint) _scope_gl_multi_count(count), \
+         UQ(i) = (_scope_gl_query_indexed(target, first, (GLsizei) UQ(n), UQ(old_buf)), glBindBuffersBase(target, first, (GLsizei) UQ(n), ids), 0); \
+         (UQ(i) == 0); (UQ(i) += 1, glBindBuffersBase(target, first, (GLsizei) UQ(n), UQ(old_buf))))
+#define _unset_glBindBuffersBase(target,first,count,ids) scope_begin_end_var(glBindBuffersBase(target, first, count, ids), glBindBuffersBase(target, first, count, NULL), bufbinds)
+
+#ifndef SCOPE_GL_MAX_VIEWPORTS
+#define SCOPE_GL_MAX_VIEWPORTS 16 /* first + count of a viewport array scope, at most GL_MAX_VIEWPORTS */
+#endif
+/* indices from SCOPE_GL_MAX_VIEWPORTS on would not fit the arrays of previous rects, they are clamped */
+static inline GLsizei _scope_gl_viewport_count(GLuint first, GLsizei count) {
+    GLsizei max = (first < SCOPE_GL_MAX_VIEWPORTS) ? (GLsizei) (SCOPE_GL_MAX_VIEWPORTS - first) : 0;
+    return _scope_gl_check(count <= max, "viewport array first + count above SCOPE_GL_MAX_VIEWPORTS, clamped") ? count : max;
+}
+/* what the _unset_ viewport and scissor scopes reset index 0 to, like the plain scopes. The other indices are reset to
+ * index 0, which is what glViewport/glScissor leave them at, so a following scope_glViewport keeps working */
+static const GLfloat _scope_gl_unset_viewport[4] = { 0, 0, 0, 0 };
+static const GLint   _scope_gl_unset_scissor[4]  = { 0, 0, 1000000000, 1000000000 };
+#define _restore_glViewportArray(first,count,rects) \
+    for (GLfloat UQ(old_views)[SCOPE_GL_MAX_VIEWPORTS][4], UQ(n) = (GLfloat) _scope_gl_viewport_count(first, count), \
+         UQ(i) = (_scope_gl_query_viewports(first, (GLsizei) UQ(n), UQ(old_views)), glViewportArrayv(first, (GLsizei) UQ(n), rects), 0); \
+         (UQ(i) == 0); (UQ(i) += 1, glViewportArrayv(first, (GLsizei) UQ(n), UQ(old_views)[0])))
+#define _unset_glViewportArray(first,count,rects) \
+    for (GLsizei UQ(n) = _scope_gl_viewport_count(first, count), UQ(i) = (glViewportArrayv(first, UQ(n), rects), 0); \
+         (UQ(i) == 0); (UQ(i) += 1, _scope_gl_unset_viewports(first, UQ(n))))
+#define _restore_glScissorArray(first,count,rects) \
+    for (GLint UQ(old_sci)[SCOPE_GL_MAX_VIEWPORTS][4], UQ(n) = (GLint) _scope_gl_viewport_count(first, count), \
+         UQ(i) = (_scope_gl_query_scissors(first, (GLsizei) UQ(n), UQ(old_sci)), glScissorArrayv(first, (GLsizei) UQ(n), rects), 0); \
+         (UQ(i) == 0); (UQ(i) += 1, glScissorArrayv(first, (GLsizei) UQ(n), UQ(old_sci)[0])))
+#define _unset_glScissorArray(first,count,rects) \
+    for (GLsizei UQ(n) = _scope_gl_viewport_count(first, count), UQ(i) = (glScissorArrayv(first, UQ(n), rects), 0); \
+         (UQ(i) == 0); (UQ(i) += 1, _scope_gl_unset_scissors(first, UQ(n))))
+
+/* the parameter set is looked up in the current sampler cache, a new set creates its sampler once */
+#define _scope_glSampler(unit,...) _scope_glBindSampler(unit, _scope_gl_sampler_getv(_SCOPE_GL_NARGS(__VA_ARGS__), __VA_ARGS__))
+/* the attachment set is looked up in the current framebuffer cache, then bound with its viewport */
+#define _scope_glRenderTarget(...) \
+    for (const scope_gl_framebuffer_entry_t* UQ(rt) = _scope_gl_framebuffer_getv(_SCOPE_GL_NARGS(__VA_ARGS__), __VA_ARGS__); UQ(rt); UQ(rt) = NULL) \
+        _scope_glBindFBO(UQ(rt)->fbo) _scope_glViewport(0, 0, UQ(rt)->width, UQ(rt)->height)
+#define _SCOPE_GL_NARGS(...) _SCOPE_GL_NARGS_(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define _SCOPE_GL_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, n, ...) n
+
 /* TODO: Texture1D,Texture2D,Texture3D,Named..Texture missing */
 /* TODO: does not restore previously attached texture, could maybe be achieved with glGetFramebufferAttachmentParameter
  * see https://registry.khronos.org/OpenGL-Refpages/gl4/html/glGetFramebufferAttachmentParameter.xhtml */
@@ -170,6 +688,12 @@
     scope_begin_end_var(glFramebufferTexture(target, attachment, textarget, texture, level), \
                         glFramebufferTexture(target, attachment, textarget,       0,     0), fbotex)
 
+/* TODO: does not restore either */
+#define _restore_glFramebufferTex2D(attachment,tex) \
+    scope_begin_end_var(glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, tex, 0), \
+                        glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D,   0, 0), fbotex2d)
+#define _unset_glFramebufferTex2D(attachment,tex) _restore_glFramebufferTex2D(attachment,tex)
+
 /* TODO does not restore */
 #define _restore_glBindRenderbuffer(target,renderbuffer)                   \
     scope_begin_end_var(glBindRenderbuffer(target, renderbuffer),          \
@@ -189,6 +713,77 @@
          (UQ(i) == 0); (UQ(i) += 1, glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, UQ(old_ssbo)), glBindBuffer(GL_SHADER_STORAGE_BUFFER, UQ(old_ssbo))))
 #define _unset_glBindSSBO(ssbo, binding) scope_begin_end_var((glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo), glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, ssbo)), (glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0), glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0)), ssbo)
 
+/* shadow variants: same as _restore_/_unset_, but the previous value comes from the tracked context state */
+#ifdef SCOPE_GL_RESTORE_STATE
+  #define _scope_gl_popval(old, unset) (old)
+#else
+  #define _scope_gl_popval(old, unset) ((void)(old), (unset))
+#endif
+
+#define _shadow_glUseProgram(id) for (GLuint UQ(prog) = _scope_gl_use_program(id), UQ(i) = 0; (UQ(i) == 0); (UQ(i) += 1, _scope_gl_use_program(_scope_gl_popval(UQ(prog), 0))))
+#define _shadow_glBindVertexArray(vao) for (GLuint UQ(old_vao) = _scope_gl_bind_vertex_array(vao), UQ(i) = 0; (UQ(i) == 0); (UQ(i) += 1, _scope_gl_bind_vertex_array(_scope_gl_popval(UQ(old_vao), 0))))
+#define _shadow_glBindTexture(target,texture) for (GLuint UQ(old_tex) = _scope_gl_bind_texture(target, texture), UQ(i) = 0; (UQ(i) == 0); (UQ(i) += 1, _scope_gl_bind_texture(target, _scope_gl_popval(UQ(old_tex), 0))))
+#define _shadow_glBindTexture2D(tex_id) for (GLuint UQ(old_tex) = _scope_gl_bind_draw_texture(tex_id), UQ(i) = 0; (UQ(i) == 0); (UQ(i) += 1, _scope_gl_bind_draw_texture(_scope_gl_popval(UQ(old_tex), 0))))
+#define _shadow_glBindBuffer(target,buffer) for (GLuint UQ(old_buf) = _scope_gl_bind_buffer(target, buffer), UQ(i) = 0; (UQ(i) == 0); (UQ(i) += 1, _scope_gl_bind_buffer(target, _scope_gl_popval(UQ(old_buf), 0))))
+#define _shadow_glEnable(enumval) for (GLboolean UQ(old_flag) = _scope_gl_enable(enumval, GL_TRUE), UQ(i) = 0; (UQ(i) == 0); (UQ(i) += 1, _scope_gl_enable(enumval, _scope_gl_popval(UQ(old_flag), GL_FALSE))))
+#define _shadow_glDisable(enumval) for (GLboolean UQ(old_flag) = _scope_gl_enable(enumval, GL_FALSE), UQ(i) = 0; (UQ(i) == 0); (UQ(i) += 1, _scope_gl_enable(enumval, _scope_gl_popval(UQ(old_flag), GL_TRUE))))
+#define _shadow_glBindFramebuffer(target, fbo) for (GLuint UQ(old_fbo) = _scope_gl_bind_framebuffer(target, fbo), UQ(i) = 0; (UQ(i) == 0); (UQ(i) += 1, _scope_gl_bind_framebuffer(target, _scope_gl_popval(UQ(old_fbo), 0))))
+#define _shadow_glBindRenderbuffer(target,renderbuffer) for (GLuint UQ(old_rb) = _scope_gl_bind_renderbuffer(target, renderbuffer), UQ(i) = 0; (UQ(i) == 0); (UQ(i) += 1, _scope_gl_bind_renderbuffer(target, _scope_gl_popval(UQ(old_rb), 0))))
+#define _shadow_glBlendEquation(eq) for (GLenum UQ(e) = _scope_gl_blend_equation(eq), UQ(i) = 0; (UQ(i) == 0); (UQ(i) += 1, _scope_gl_blend_equation(_scope_gl_popval(UQ(e), GL_FUNC_ADD))))
+#define _shadow_glCullFace(mode) for (GLenum UQ(m) = _scope_gl_cull_face(mode), UQ(i) = 0; (UQ(i) == 0); (UQ(i) += 1, _scope_gl_cull_face(_scope_gl_popval(UQ(m), GL_BACK))))
+#define _shadow_glBindSampler(unit,sampler) for (GLuint UQ(old_smp) = _scope_gl_bind_sampler(unit, sampler), UQ(i) = 0; (UQ(i) == 0); (UQ(i) += 1, _scope_gl_bind_sampler(unit, _scope_gl_popval(UQ(old_smp), 0))))
+#define _shadow_glActiveTexture(texture) for (GLuint UQ(old_unit) = _scope_gl_active_texture((texture) - GL_TEXTURE0), UQ(i) = 0; (UQ(i) == 0); (UQ(i) += 1, _scope_gl_active_texture(_scope_gl_popval(UQ(old_unit), 0))))
+#define _shadow_glBindTextures(first,count,ids) \
+    for (GLuint UQ(old_tex)[SCOPE_GL_MAX_MULTI_BIND], UQ(n) = (GLuint) _scope_gl_multi_count_2d(count, ids), \
+         UQ(i) = (_scope_gl_bind_textures(first, (GLsizei) UQ(n), ids, UQ(old_tex)), 0); (UQ(i) == 0); \
+         (UQ(i) += 1, _scope_gl_bind_textures(first, (GLsizei) UQ(n), _scope_gl_popval(UQ(old_tex), (const GLuint*) NULL), NULL)))
+#define _shadow_glBindSamplers(first,count,ids) \
+    for (GLuint UQ(old_smp)[SCOPE_GL_MAX_MULTI_BIND], UQ(n) = (GLuint) _scope_gl_multi_count(count), \
+         UQ(i) = (_scope_gl_bind_samplers(first, (GLsizei) UQ(n), ids, UQ(old_smp)), 0); (UQ(i) == 0); \
+         (UQ(i) += 1, _scope_gl_bind_samplers(first, (GLsizei) UQ(n), _scope_gl_popval(UQ(old_smp), (const GLuint*) NULL), NULL)))
+#define _shadow_glBindBuffersBase(target,first,count,ids) \
+    for (GLuint UQ(old_buf)[SCOPE_GL_MAX_MULTI_BIND], UQ(n) = (GLuint) _scope_gl_multi_count(count), \
+         UQ(i) = (_scope_gl_bind_buffers_base(target, first, (GLsizei) UQ(n), ids, UQ(old_buf)), 0); (UQ(i) == 0); \
+         (UQ(i) += 1, _scope_gl_bind_buffers_base(target, first, (GLsizei) UQ(n), _scope_gl_popval(UQ(old_buf), (const GLuint*) NULL), NULL)))
+#define _shadow_glVertexAttribMask(mask) for (GLuint UQ(old_attribs) = _scope_gl_vertex_attrib_mask(mask), UQ(i) = 0; (UQ(i) == 0); (UQ(i) += 1, _scope_gl_vertex_attrib_mask(_scope_gl_popval(UQ(old_attribs), 0))))
+#define _shadow_glFrontFace(orient) for (GLenum UQ(fo) = _scope_gl_front_face(orient), UQ(i) = 0; (UQ(i) == 0); (UQ(i) += 1, _scope_gl_front_face(_scope_gl_popval(UQ(fo), GL_CCW))))
+
+#define _shadow_glViewport(x,y,w,h) \
+    for (GLint UQ(view)[4], UQ(i) = (_scope_gl_viewport(x, y, w, h, UQ(view)), 0); (UQ(i) == 0); \
+         (UQ(i) += 1, _scope_gl_viewport(_scope_gl_popval(UQ(view)[0], 0), _scope_gl_popval(UQ(view)[1], 0), _scope_gl_popval(UQ(view)[2], 0), _scope_gl_popval(UQ(view)[3], 0), NULL)))
+#define _shadow_glScissor(x,y,w,h) \
+    for (GLint UQ(old_sci)[4], UQ(i) = (_scope_gl_scissor(x, y, w, h, UQ(old_sci)), 0); (UQ(i) == 0); \
+         (UQ(i) += 1, _scope_gl_scissor(_scope_gl_popval(UQ(old_sci)[0], 0), _scope_gl_popval(UQ(old_sci)[1], 0), _scope_gl_popval(UQ(old_sci)[2], 1000000000), _scope_gl_popval(UQ(old_sci)[3], 1000000000), NULL)))
+#define _shadow_glViewportArray(first,count,rects) \
+    for (GLfloat UQ(old_views)[SCOPE_GL_MAX_VIEWPORTS][4], UQ(n) = (GLfloat) _scope_gl_viewport_count(first, count), \
+         UQ(i) = (_scope_gl_viewport_array(first, (GLsizei) UQ(n), rects, UQ(old_views)), 0); (UQ(i) == 0); \
+         (UQ(i) += 1, _scope_gl_viewport_array(first, (GLsizei) UQ(n), _scope_gl_popval(UQ(old_views)[0], (const GLfloat*) NULL), NULL)))
+#define _shadow_glScissorArray(first,count,rects) \
+    for (GLint UQ(old_sci)[SCOPE_GL_MAX_VIEWPORTS][4], UQ(n) = (GLint) _scope_gl_viewport_count(first, count), \
+         UQ(i) = (_scope_gl_scissor_array(first, (GLsizei) UQ(n), rects, UQ(old_sci)), 0); (UQ(i) == 0); \
+         (UQ(i) += 1, _scope_gl_scissor_array(first, (GLsizei) UQ(n), _scope_gl_popval(UQ(old_sci)[0], (const GLint*) NULL), NULL)))
+#define _shadow_glClearColor(r,g,b,a) \
+    for (GLfloat UQ(clear)[4], UQ(i) = (_scope_gl_clear_color(r, g, b, a, UQ(clear)), 0); (UQ(i) == 0); \
+         (UQ(i) += 1, _scope_gl_clear_color(_scope_gl_popval(UQ(clear)[0], 0), _scope_gl_popval(UQ(clear)[1], 0), _scope_gl_popval(UQ(clear)[2], 0), _scope_gl_popval(UQ(clear)[3], 0), NULL)))
+#define _shadow_glBlendFunc(src,dst) \
+    for (GLenum UQ(blend)[2], UQ(i) = (_scope_gl_blend_func(src, dst, UQ(blend)), 0); (UQ(i) == 0); \
+         (UQ(i) += 1, _scope_gl_blend_func(_scope_gl_popval(UQ(blend)[0], 0), _scope_gl_popval(UQ(blend)[1], 0), NULL)))
+#define _shadow_glBindSSBO(ssbo, binding) \
+    for (GLuint UQ(old_ssbo)[2], UQ(i) = (_scope_gl_bind_ssbo(ssbo, binding, UQ(old_ssbo)), 0); (UQ(i) == 0); \
+         (UQ(i) += 1, _scope_gl_bind_ssbo(_scope_gl_popval(UQ(old_ssbo)[0], 0), binding, NULL), _scope_gl_bind_buffer(GL_SHADER_STORAGE_BUFFER, _scope_gl_popval(UQ(old_ssbo)[1], 0))))
+
+/* prev holds the values the block overwrites (or their unset values), the loop ends once they are applied again */
+#define _shadow_glStateBlock(block) \
+    for (scope_gl_state_block_t UQ(prev), *UQ(blk) = _scope_gl_push_state_block(&UQ(prev), block); (UQ(blk) != NULL); \
+         UQ(blk) = (_scope_gl_apply_state_block(&UQ(prev)), (scope_gl_state_block_t*) NULL))
+
+#ifdef SCOPE_GL_LAZY_STATE
+#define _lazy_glRecord(cmdbuf) \
+    for (scope_gl_cmdbuf_t* UQ(rec) = _scope_gl_begin_record(cmdbuf); (UQ(rec) != NULL); UQ(rec) = (_scope_gl_end_record(UQ(rec)), (scope_gl_cmdbuf_t*) NULL))
+#define _lazy_glDrawBatch(batch) \
+    for (scope_gl_batch_t* UQ(prev) = _scope_gl_begin_batch(batch), *UQ(bat) = (batch); (UQ(bat) != NULL); UQ(bat) = (_scope_gl_end_batch(UQ(bat), UQ(prev)), (scope_gl_batch_t*) NULL))
+#endif
+
 /* NOTE: the following can only be restored, because they cannot be set to zero/GL_NONE */
 // ext = {i,f,fv,iv,Iiv,Iuiv}
 /* TODO: use cross-platform typeof() */
@@ -196,18 +791,72 @@
     for (typeof(val) UQ(t2d), UQ(i) = (glGetTexParameter##ext##v(GL_TEXTURE_2D, param, &UQ(t2d)), glTexParameter##ext(GL_TEXTURE_2D, param, val), 0); \
          (UQ(i) == 0); (UQ(i) += 1, glTexParameter##ext(GL_TEXTURE_2D, param, UQ(t2d))))
 
+/* edits of a named object: with SCOPE_GL_DSA no bind point is touched, otherwise the object is bound for the scope */
+#define _dsa_glTextureParameter(texture,ext,param,val) \
+    for (typeof(val) UQ(tp), UQ(i) = (glGetTextureParameter##ext##v(texture, param, &UQ(tp)), glTextureParameter##ext(texture, param, val), 0); \
+         (UQ(i) == 0); (UQ(i) += 1, glTextureParameter##ext(texture, param, UQ(tp))))
+#define _dsa_glNamedFramebufferTexture(fbo,attachment,texture,level) \
+    scope_begin_end_var(glNamedFramebufferTexture(fbo, attachment, texture, level), glNamedFramebufferTexture(fbo, attachment, 0, 0), fbotex)
+
+/* NOTE: the binding is applied before the edit and again before undoing it, lazy scopes in between may have moved it */
+#define _bind_glTextureParameter(texture,ext,param,val) \
+    _scope_glBindTexture(GL_TEXTURE_2D, texture) \
+    for (typeof(val) UQ(tp), UQ(i) = (_scope_gl_flush(SCOPE_GL_STATE_TEXTURES), glGetTexParameter##ext##v(GL_TEXTURE_2D, param, &UQ(tp)), glTexParameter##ext(GL_TEXTURE_2D, param, val), 0); \
+         (UQ(i) == 0); (UQ(i) += 1, _scope_gl_flush(SCOPE_GL_STATE_TEXTURES), glTexParameter##ext(GL_TEXTURE_2D, param, UQ(tp))))
+#define _bind_glNamedFramebufferTexture(fbo,attachment,texture,level) \
+    _scope_glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo) \
+    scope_begin_end_var((_scope_gl_flush(SCOPE_GL_STATE_FRAMEBUFFER), glFramebufferTexture(GL_DRAW_FRAMEBUFFER, attachment, texture, level)), \
+                        (_scope_gl_flush(SCOPE_GL_STATE_FRAMEBUFFER), glFramebufferTexture(GL_DRAW_FRAMEBUFFER, attachment,       0,     0)), fbotex)
+
+/* edits of the bound objects in shadow mode, the same flushes (no-ops without SCOPE_GL_LAZY_STATE) */
+#define _shadow_glTex2DParameter(ext,param,val) \
+    for (typeof(val) UQ(t2d), UQ(i) = (_scope_gl_flush(SCOPE_GL_STATE_TEXTURES), glGetTexParameter##ext##v(GL_TEXTURE_2D, param, &UQ(t2d)), glTexParameter##ext(GL_TEXTURE_2D, param, val), 0); \
+         (UQ(i) == 0); (UQ(i) += 1, _scope_gl_flush(SCOPE_GL_STATE_TEXTURES), glTexParameter##ext(GL_TEXTURE_2D, param, UQ(t2d))))
+#define _shadow_glFramebufferTexture(target,attachment,textarget,texture,level) \
+    scope_begin_end_var((_scope_gl_flush(SCOPE_GL_STATE_FRAMEBUFFER), glFramebufferTexture(target, attachment, textarget, texture, level)), \
+                        (_scope_gl_flush(SCOPE_GL_STATE_FRAMEBUFFER), glFramebufferTexture(target, attachment, textarget,       0,     0)), fbotex)
+#define _shadow_glFramebufferTex2D(attachment,tex) \
+    scope_begin_end_var((_scope_gl_flush(SCOPE_GL_STATE_FRAMEBUFFER), glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, tex, 0)), \
+                        (_scope_gl_flush(SCOPE_GL_STATE_FRAMEBUFFER), glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D,   0, 0)), fbotex2d)
+#define _shadow_glFramebufferRenderbuffer(fbo,attachment,renderbuffer) \
+    scope_begin_end_var((_scope_gl_flush(SCOPE_GL_STATE_FRAMEBUFFER), glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, renderbuffer)), \
+                        (_scope_gl_flush(SCOPE_GL_STATE_FRAMEBUFFER), glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER,            0)), fborenbuf)
+
+#ifdef SCOPE_GL_DSA
+#define _scope_glTextureParameter(texture,ext,param,val)                         _scope_gl_scope_hook(TEX_PARAMETERS, 1, 2) _dsa_glTextureParameter(texture,ext,param,val)
+#define _scope_glNamedFramebufferTexture(fbo,attachment,texture,level)           _scope_gl_scope_hook(FRAMEBUFFER,    0, 2) _dsa_glNamedFramebufferTexture(fbo,attachment,texture,level)
+#else
+#define _scope_glTextureParameter(texture,ext,param,val)                         _scope_gl_scope_hook(TEX_PARAMETERS, 1, 2) _bind_glTextureParameter(texture,ext,param,val)
+#define _scope_glNamedFramebufferTexture(fbo,attachment,texture,level)           _scope_gl_scope_hook(FRAMEBUFFER,    0, 2) _bind_glNamedFramebufferTexture(fbo,attachment,texture,level)
+#endif
+
 
 /* for pushing and popping uniform values */
 /* NOTE: these are extremely wasteful */
-#define scope_glUniformMatrix4fv(matrix,name) \
+#define _restore_glUniformMatrix4fv(matrix,name) \
     for (GLint UQ(prog), UQ(j) = (glGetIntegerv(GL_CURRENT_PROGRAM, &UQ(prog)),0); (UQ(j) == 0); UQ(j) += 1) \
     for (GLfloat UQ(mat)[16], UQ(i) = (glGetUniformfv(UQ(prog), glGetUniformLocation(UQ(prog), name), UQ(mat)), glUniformMatrix4fv(glGetUniformLocation(UQ(prog), name), 1, GL_FALSE, matrix), 0); \
          (UQ(i) == 0); (UQ(i) += 1, glUniformMatrix4fv(glGetUniformLocation(UQ(prog), name), 1, GL_FALSE, UQ(mat))))
-#define scope_glUniformfv(val,name) \
+#define _restore_glUniformfv(val,name) \
     for (GLint UQ(prog), UQ(j) = (glGetIntegerv(GL_CURRENT_PROGRAM, &UQ(prog)),0); (UQ(j) == 0); UQ(j) += 1) \
     for (GLfloat UQ(old_val), UQ(i) = (glGetUniformfv(UQ(prog), glGetUniformLocation(UQ(prog), name), &UQ(old_val)), glUniform1f(glGetUniformLocation(UQ(prog), name), val), 0); \
          (UQ(i) == 0); (UQ(i) += 1, glUniform1f(glGetUniformLocation(UQ(prog), name), UQ(old_val))))
 
+/* single values and vectors, the old value is read back into 16 words of scratch space */
+#define _restore_glUniformv1(ext,values,name) \
+    for (GLint UQ(prog), UQ(j) = (glGetIntegerv(GL_CURRENT_PROGRAM, &UQ(prog)),0); (UQ(j) == 0); UQ(j) += 1) \
+    for (GLint UQ(loc) = glGetUniformLocation(UQ(prog), name), UQ(old)[16], UQ(i) = (_scope_gl_get_uniform_##ext(UQ(prog), UQ(loc), UQ(old)), _scope_gl_upload_##ext(UQ(loc), 1, values), 0); \
+         (UQ(i) == 0); (UQ(i) += 1, _scope_gl_upload_##ext(UQ(loc), 1, UQ(old))))
+#define _restore_glUniform1i(val,name) for (GLint UQ(ival) = (val), UQ(k) = 0; (UQ(k) == 0); UQ(k) += 1) _restore_glUniformv1(1i, &UQ(ival), name)
+
+/* shadow variants look up the location once per program and name and take the old value from the per-program value
+ * store, see _scope_gl_uniform_push(). Old values live on the uniform stack of the context until the scope is left */
+#define _shadow_glUniformv(ext,values,count,name) \
+    for (GLint UQ(loc) = _scope_gl_uniform_location(name), UQ(top) = _scope_gl_uniform_push_##ext(UQ(loc), count, values), UQ(i) = 0; \
+         (UQ(i) == 0); (UQ(i) += 1, _scope_gl_uniform_pop_##ext(UQ(loc), count, UQ(top))))
+#define _shadow_glUniformfv(val,name) for (GLfloat UQ(fval) = (val), UQ(k) = 0; (UQ(k) == 0); UQ(k) += 1) _shadow_glUniformv(1f, &UQ(fval), 1, name)
+#define _shadow_glUniform1i(val,name) for (GLint   UQ(ival) = (val), UQ(k) = 0; (UQ(k) == 0); UQ(k) += 1) _shadow_glUniformv(1i, &UQ(ival), 1, name)
+
 /* helper macros */
 #define TOKEN_PASTE(a, b) a##b
 #define CONCAT(a,b) TOKEN_PASTE(a,b)
@@ -216,19 +865,2909 @@
 #define scope_begin_end_var(begin, end, var) \
     for (int UQ(var) = (begin, 0); (UQ(var) == 0); (UQ(var) += 1), end)
 
+/*          target                        , binding                                 */
+#define _SCOPE_GL_TEXTURE_TARGETS(X)                                                          \
+        X(GL_TEXTURE_1D                   , GL_TEXTURE_BINDING_1D                   )         \
+        X(GL_TEXTURE_2D                   , GL_TEXTURE_BINDING_2D                   )         \
+        X(GL_TEXTURE_3D                   , GL_TEXTURE_BINDING_3D                   )         \
+        X(GL_TEXTURE_1D_ARRAY             , GL_TEXTURE_BINDING_1D_ARRAY             )         \
+        X(GL_TEXTURE_2D_ARRAY             , GL_TEXTURE_BINDING_2D_ARRAY             )         \
+        X(GL_TEXTURE_RECTANGLE            , GL_TEXTURE_BINDING_RECTANGLE            )         \
+        X(GL_TEXTURE_CUBE_MAP             , GL_TEXTURE_BINDING_CUBE_MAP             )         \
+        X(GL_TEXTURE_CUBE_MAP_ARRAY       , GL_TEXTURE_BINDING_CUBE_MAP_ARRAY       )         \
+        X(GL_TEXTURE_BUFFER               , GL_TEXTURE_BINDING_BUFFER               )         \
+        X(GL_TEXTURE_2D_MULTISAMPLE       , GL_TEXTURE_BINDING_2D_MULTISAMPLE       )         \
+        X(GL_TEXTURE_2D_MULTISAMPLE_ARRAY , GL_TEXTURE_BINDING_2D_MULTISAMPLE_ARRAY )
+
 static inline GLuint _scope_gl_map_texture_target_to_binding(GLuint target) {
+    #define _SCOPE_GL_MAP_BINDING(target, binding) case target: return binding;
+    switch (target) {
+        _SCOPE_GL_TEXTURE_TARGETS(_SCOPE_GL_MAP_BINDING)
+        default: return 0;
+    }
+}
+
+/* NOTE: GL_ELEMENT_ARRAY_BUFFER is missing on purpose, it is part of the vertex array object and not of the context */
+/*          target                        , binding                                 */
+#define _SCOPE_GL_BUFFER_TARGETS(X)                                                           \
+        X(GL_ARRAY_BUFFER                 , GL_ARRAY_BUFFER_BINDING                 )         \
+        X(GL_ATOMIC_COUNTER_BUFFER        , GL_ATOMIC_COUNTER_BUFFER_BINDING        )         \
+        X(GL_COPY_READ_BUFFER             , GL_COPY_READ_BUFFER_BINDING             )         \
+        X(GL_COPY_WRITE_BUFFER            , GL_COPY_WRITE_BUFFER_BINDING            )         \
+        X(GL_DISPATCH_INDIRECT_BUFFER     , GL_DISPATCH_INDIRECT_BUFFER_BINDING     )         \
+        X(GL_DRAW_INDIRECT_BUFFER         , GL_DRAW_INDIRECT_BUFFER_BINDING         )         \
+        X(GL_PIXEL_PACK_BUFFER            , GL_PIXEL_PACK_BUFFER_BINDING            )         \
+        X(GL_PIXEL_UNPACK_BUFFER          , GL_PIXEL_UNPACK_BUFFER_BINDING          )         \
+        X(GL_SHADER_STORAGE_BUFFER        , GL_SHADER_STORAGE_BUFFER_BINDING        )         \
+        X(GL_TEXTURE_BUFFER               , GL_TEXTURE_BUFFER_BINDING               )         \
+        X(GL_TRANSFORM_FEEDBACK_BUFFER    , GL_TRANSFORM_FEEDBACK_BUFFER_BINDING    )         \
+        X(GL_UNIFORM_BUFFER               , GL_UNIFORM_BUFFER_BINDING               )
+
+static inline GLuint _scope_gl_map_buffer_target_to_binding(GLuint target) {
     switch (target) {
-        case GL_TEXTURE_1D                   : return GL_TEXTURE_BINDING_1D                   ;
-        case GL_TEXTURE_2D                   : return GL_TEXTURE_BINDING_2D                   ;
-        case GL_TEXTURE_3D                   : return GL_TEXTURE_BINDING_3D                   ;
-        case GL_TEXTURE_1D_ARRAY             : return GL_TEXTURE_BINDING_1D_ARRAY             ;
-        case GL_TEXTURE_2D_ARRAY             : return GL_TEXTURE_BINDING_2D_ARRAY             ;
-        case GL_TEXTURE_RECTANGLE            : return GL_TEXTURE_BINDING_RECTANGLE            ;
-        case GL_TEXTURE_CUBE_MAP             : return GL_TEXTURE_BINDING_CUBE_MAP             ;
-        case GL_TEXTURE_CUBE_MAP_ARRAY       : return GL_TEXTURE_BINDING_CUBE_MAP_ARRAY       ;
-        case GL_TEXTURE_BUFFER               : return GL_TEXTURE_BINDING_BUFFER               ;
-        case GL_TEXTURE_2D_MULTISAMPLE       : return GL_TEXTURE_BINDING_2D_MULTISAMPLE       ;
-        case GL_TEXTURE_2D_MULTISAMPLE_ARRAY : return GL_TEXTURE_BINDING_2D_MULTISAMPLE_ARRAY ;
+        _SCOPE_GL_BUFFER_TARGETS(_SCOPE_GL_MAP_BINDING)
+        case GL_ELEMENT_ARRAY_BUFFER: return GL_ELEMENT_ARRAY_BUFFER_BINDING;
         default: return 0;
     }
 }
+
+/* GL_SAMPLER_BINDING and GL_TEXTURE_BINDING_* are per active unit */
+static inline void _scope_gl_query_units(GLuint first, GLsizei count, GLenum pname, GLuint* out) {
+    GLint active, v;
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &active);
+    for (GLsizei i = 0; i < count; i++) {
+        glActiveTexture(GL_TEXTURE0 + first + (GLuint) i);
+        glGetIntegerv(pname, &v); out[i] = (GLuint) v;
+    }
+    glActiveTexture((GLenum) active);
+}
+static inline GLuint _scope_gl_query_unit(GLuint unit, GLenum pname) { GLuint v; _scope_gl_query_units(unit, 1, pname, &v); return v; }
+
+static inline void _scope_gl_query_viewports(GLuint first, GLsizei count, GLfloat (*out)[4]) {
+    for (GLsizei i = 0; i < count; i++) { glGetFloati_v(GL_VIEWPORT, first + (GLuint) i, out[i]); }
+}
+static inline void _scope_gl_query_scissors(GLuint first, GLsizei count, GLint (*out)[4]) {
+    for (GLsizei i = 0; i < count; i++) { glGetIntegeri_v(GL_SCISSOR_BOX, first + (GLuint) i, out[i]); }
+}
+/* NOTE: count is clamped already, index 0 is queried if the array does not reset it */
+static inline void _scope_gl_unset_viewports(GLuint first, GLsizei count) {
+    GLfloat rects[SCOPE_GL_MAX_VIEWPORTS][4], rect0[4];
+    if (first == 0) { for (int k = 0; k < 4; k++) { rect0[k] = _scope_gl_unset_viewport[k]; } } else { glGetFloati_v(GL_VIEWPORT, 0, rect0); }
+    for (GLsizei i = 0; i < count; i++) { for (int k = 0; k < 4; k++) { rects[i][k] = rect0[k]; } }
+    glViewportArrayv(first, count, rects[0]);
+}
+static inline void _scope_gl_unset_scissors(GLuint first, GLsizei count) {
+    GLint rects[SCOPE_GL_MAX_VIEWPORTS][4], rect0[4];
+    if (first == 0) { for (int k = 0; k < 4; k++) { rect0[k] = _scope_gl_unset_scissor[k]; } } else { glGetIntegeri_v(GL_SCISSOR_BOX, 0, rect0); }
+    for (GLsizei i = 0; i < count; i++) { for (int k = 0; k < 4; k++) { rects[i][k] = rect0[k]; } }
+    glScissorArrayv(first, count, rects[0]);
+}
+
+#ifndef SCOPE_GL_MAX_VERTEX_ATTRIBS
+#define SCOPE_GL_MAX_VERTEX_ATTRIBS 16 /* attributes covered by scope_glVertexAttribMask, at most 32 and GL_MAX_VERTEX_ATTRIBS */
+#endif
+
+/* index of the lowest set bit, m must not be 0 */
+static inline int _scope_gl_ctz(GLuint m) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(m);
+#else
+    int i = 0;
+    while (!(m & 1u)) { m >>= 1; i++; }
+    return i;
+#endif
+}
+
+/* enabled attributes of the bound vertex array */
+static inline GLuint _scope_gl_query_vertex_attribs(void) {
+    GLuint mask = 0;
+    GLint  enabled;
+    for (GLuint i = 0; i < SCOPE_GL_MAX_VERTEX_ATTRIBS; i++) { glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &enabled); mask |= (GLuint) (enabled != 0) << i; }
+    return mask;
+}
+
+/* enables the attributes in diff that are set in mask and disables the other ones in diff */
+static inline void _scope_gl_toggle_vertex_attribs(GLuint diff, GLuint mask) {
+    for (; diff; diff &= diff - 1) {
+        GLuint i = (GLuint) _scope_gl_ctz(diff);
+        if ((mask >> i) & 1) { glEnableVertexAttribArray(i); } else { glDisableVertexAttribArray(i); }
+        _scope_gl_stat(sets, SCOPE_GL_STAT_VERTEX_ATTRIBS);
+    }
+}
+
+static inline void _scope_gl_query_indexed(GLenum target, GLuint first, GLsizei count, GLuint* out) {
+    GLint v;
+    for (GLsizei i = 0; i < count; i++) { glGetIntegeri_v(_scope_gl_map_buffer_target_to_binding(target), first + (GLuint) i, &v); out[i] = (GLuint) v; }
+}
+
+/*   ext     , components, is_int, upload                                                      */
+#define _SCOPE_GL_UNIFORM_KINDS(X)                                                                   \
+    X(1f       ,  1, 0, glUniform1fv(loc, count, (const GLfloat*) v)                   )            \
+    X(2f       ,  2, 0, glUniform2fv(loc, count, (const GLfloat*) v)                   )            \
+    X(3f       ,  3, 0, glUniform3fv(loc, count, (const GLfloat*) v)                   )            \
+    X(4f       ,  4, 0, glUniform4fv(loc, count, (const GLfloat*) v)                   )            \
+    X(1i       ,  1, 1, glUniform1iv(loc, count, (const GLint*)   v)                   )            \
+    X(2i       ,  2, 1, glUniform2iv(loc, count, (const GLint*)   v)                   )            \
+    X(3i       ,  3, 1, glUniform3iv(loc, count, (const GLint*)   v)                   )            \
+    X(4i       ,  4, 1, glUniform4iv(loc, count, (const GLint*)   v)                   )            \
+    X(Matrix3f ,  9, 0, glUniformMatrix3fv(loc, count, GL_FALSE, (const GLfloat*) v)   )            \
+    X(Matrix4f , 16, 0, glUniformMatrix4fv(loc, count, GL_FALSE, (const GLfloat*) v)   )
+
+/* _scope_gl_upload_<ext>() and _scope_gl_get_uniform_<ext>() for every entry above */
+#define _SCOPE_GL_UNIFORM_UPLOAD(ext, comps, is_int, upload)                                                   \
+    static inline void _scope_gl_upload_##ext(GLint loc, GLsizei count, const void* v) { upload; }             \
+    static inline void _scope_gl_get_uniform_##ext(GLint prog, GLint loc, void* out) {                         \
+        if (loc < 0) { return; }                                                                               \
+        if (is_int) { glGetUniformiv((GLuint) prog, loc, (GLint*) out); } else { glGetUniformfv((GLuint) prog, loc, (GLfloat*) out); } \
+    }
+_SCOPE_GL_UNIFORM_KINDS(_SCOPE_GL_UNIFORM_UPLOAD)
+
+/*
+** GPU timers: scope_glTimer(name) puts a GL_TIMESTAMP query before and after the scope. The queries of a frame are
+** read back SCOPE_GL_TIMER_FRAMES - 1 frames later, when the GPU is long done with them, so reading never stalls.
+** Works in all modes, the timers are per GL context like the queries:
+**
+**   scope_gl_timers_t timers;
+**   scope_gl_timers_init(&timers);          // with the GL context current
+**   scope_gl_timers_make_current(&timers);
+**   ...
+**   scope_glTimer("frame") {
+**       scope_glTimer("shadow_pass") { ... }
+**       scope_glTimer("main_pass")   { ... }
+**   }
+**   scope_gl_timers_frame(&timers);         // once per frame outside of all timers, e.g. after swapping
+**   for (GLuint i = 0; i < timers.result_count; i++) {
+**       const scope_gl_timer_result_t* r = &timers.results[i];
+**       printf("%*s%s: %.3f ms\n", 2 * r->depth, "", r->name, r->ns / 1e6);
+**   }
+**
+** Results are in the order the timers were entered, depth/parent give the hierarchy. If the GPU is more than
+** SCOPE_GL_TIMER_FRAMES - 1 frames behind, the results of that frame are dropped (counted in 'missed') and
+** result_count is 0 until the next scope_gl_timers_frame(), as it is for frames without timers.
+*/
+#ifndef SCOPE_GL_TIMER_FRAMES
+#define SCOPE_GL_TIMER_FRAMES 3  /* frames of queries in flight */
+#endif
+#ifndef SCOPE_GL_MAX_TIMERS
+#define SCOPE_GL_MAX_TIMERS   64 /* timer scopes per frame, further ones are not measured */
+#endif
+
+typedef struct scope_gl_timer_result_t {
+    const char* name;
+    GLuint      depth;                                                       /* 0 for timers outside of all others */
+    GLint       parent;                                                      /* index of the enclosing timer or -1 */
+    GLuint64    ns;                                                          /* GPU time between begin and end */
+} scope_gl_timer_result_t;
+
+typedef struct scope_gl_timer_frame_t {
+    GLuint      queries[2 * SCOPE_GL_MAX_TIMERS];                            /* begin and end per timer */
+    const char* names[SCOPE_GL_MAX_TIMERS];
+    GLint       parents[SCOPE_GL_MAX_TIMERS];
+    GLuint      depths[SCOPE_GL_MAX_TIMERS];
+    GLuint      count;
+    GLuint      last;                                                        /* query issued last, when it is done all are */
+} scope_gl_timer_frame_t;
+
+typedef struct scope_gl_timers_t {
+    scope_gl_timer_frame_t  frames[SCOPE_GL_TIMER_FRAMES];
+    GLuint                  frame;                                           /* the one being issued */
+    GLint                   open;                                            /* innermost entered timer or -1 */
+    scope_gl_timer_result_t results[SCOPE_GL_MAX_TIMERS];                    /* of the oldest frame in flight */
+    GLuint                  result_count;
+    GLuint                  missed;
+} scope_gl_timers_t;
+
+extern SCOPE_GL_THREAD_LOCAL scope_gl_timers_t* _scope_gl_timers;
+void scope_gl_timers_init(scope_gl_timers_t* timers);
+void scope_gl_timers_destroy(scope_gl_timers_t* timers);
+void scope_gl_timers_frame(scope_gl_timers_t* timers); /* reads back the oldest frame into results, starts a new one */
+GLint _scope_gl_timer_begin(const char* name);
+void _scope_gl_timer_end(GLint timer);
+static inline void scope_gl_timers_make_current(scope_gl_timers_t* timers) { _scope_gl_timers = timers; }
+
+/* NOTE: without current timers or when the frame is full, the scope is not measured (timer -1) */
+#define _scope_glTimer(name) for (GLint UQ(timer) = _scope_gl_timer_begin(name), UQ(i) = 0; (UQ(i) == 0); (UQ(i) += 1, _scope_gl_timer_end(UQ(timer))))
+
+/*
+** Sampler cache: scope_glSampler(unit, pname, value, ...) binds a sampler object with the given integer parameters to
+** the unit and restores the previous sampler on exit, instead of changing (and revalidating) the texture itself:
+**
+**   scope_gl_samplers_t samplers;
+**   scope_gl_samplers_init(&samplers);          // with the GL context current
+**   scope_gl_samplers_make_current(&samplers);
+**   ...
+**   scope_glSampler(0, GL_TEXTURE_MIN_FILTER, GL_NEAREST, GL_TEXTURE_MAG_FILTER, GL_NEAREST) { glDrawArrays(...); }
+**
+** Sampler objects are created on the first use of a parameter set and live until scope_gl_samplers_destroy(). The
+** same parameters in a different order get their own sampler. Without a current cache or once it is full the
+** scope binds sampler 0, i.e. the texture parameters apply. Works in all modes.
+*/
+#ifndef SCOPE_GL_MAX_SAMPLERS
+#define SCOPE_GL_MAX_SAMPLERS       64 /* power of two, distinct parameter sets */
+#endif
+#ifndef SCOPE_GL_MAX_SAMPLER_PARAMS
+#define SCOPE_GL_MAX_SAMPLER_PARAMS  8 /* pname/value pairs per set */
+#endif
+
+typedef struct scope_gl_sampler_entry_t {
+    GLuint  sampler;                                                         /* 0 for a free slot */
+    GLuint  hash;
+    GLsizei count;                                                           /* ints in params */
+    GLint   params[2 * SCOPE_GL_MAX_SAMPLER_PARAMS];
+} scope_gl_sampler_entry_t;
+
+typedef struct scope_gl_samplers_t {
+    scope_gl_sampler_entry_t entries[SCOPE_GL_MAX_SAMPLERS];                 /* open addressing */
+    GLuint                   count;
+    GLuint                   rejected;                                       /* lookups that found the cache full or too many params */
+} scope_gl_samplers_t;
+
+extern SCOPE_GL_THREAD_LOCAL scope_gl_samplers_t* _scope_gl_samplers;
+void scope_gl_samplers_init(scope_gl_samplers_t* samplers);
+void scope_gl_samplers_destroy(scope_gl_samplers_t* samplers);
+GLuint scope_gl_sampler_get(const GLint* params, GLsizei count); /* cached sampler of the current cache or 0 */
+GLuint _scope_gl_sampler_getv(GLsizei count, ...);                /* count GLint arguments */
+static inline void scope_gl_samplers_make_current(scope_gl_samplers_t* samplers) { _scope_gl_samplers = samplers; }
+
+/*
+** Framebuffer cache: scope_glRenderTarget(attachment, texture, ...) binds a framebuffer object with exactly these
+** attachments (level 0) and a viewport covering them, and restores both on exit. The attachments of a cached
+** framebuffer never change, so completeness is checked once instead of on every re-attach:
+**
+**   scope_gl_framebuffers_t framebuffers;
+**   scope_gl_framebuffers_init(&framebuffers);      // with the GL context current
+**   scope_gl_framebuffers_make_current(&framebuffers);
+**   ...
+**   scope_glRenderTarget(GL_COLOR_ATTACHMENT0, bloom, GL_DEPTH_ATTACHMENT, SCOPE_GL_RENDERBUFFER(depth)) { glDrawArrays(...); }
+**
+** Framebuffers are created with draw buffers for their color attachments (in the given order) on the first use of an
+** attachment set. The cache is keyed by names only, so after a texture or renderbuffer was resized or deleted call
+** scope_gl_framebuffers_forget(&framebuffers, object) with the same name argument (0 forgets every set), outside
+** the scopes using them. The viewport is the size of the smallest attachment. Without a current cache, once it is
+** full or if the set is not complete the scope binds framebuffer 0 with an empty viewport, i.e. nothing is drawn
+** (counted in 'rejected', reported with SCOPE_GL_CHECK_ERRORS).
+** NOTE: textures have to be GL_TEXTURE_2D without SCOPE_GL_DSA (for the size query). Works in all modes.
+*/
+#ifndef SCOPE_GL_MAX_FRAMEBUFFERS
+#define SCOPE_GL_MAX_FRAMEBUFFERS   32 /* power of two, distinct attachment sets */
+#endif
+#ifndef SCOPE_GL_MAX_ATTACHMENTS
+#define SCOPE_GL_MAX_ATTACHMENTS     6 /* attachment/object pairs per set */
+#endif
+#define SCOPE_GL_RENDERBUFFER(rb) ((GLuint) (rb) | 0x80000000u) /* attaches a renderbuffer instead of a texture */
+
+typedef struct scope_gl_framebuffer_entry_t {
+    GLuint  fbo;                                                             /* 0 for a free slot */
+    GLuint  hash;
+    GLsizei count;                                                           /* GLuints in attachments */
+    GLuint  attachments[2 * SCOPE_GL_MAX_ATTACHMENTS];
+    GLsizei width, height;                                                   /* 0 if incomplete */
+} scope_gl_framebuffer_entry_t;
+
+typedef struct scope_gl_framebuffers_t {
+    scope_gl_framebuffer_entry_t entries[SCOPE_GL_MAX_FRAMEBUFFERS];         /* open addressing */
+    GLuint                       count;
+    GLuint                       rejected;                                   /* lookups that found the cache full, too many attachments or an incomplete set */
+} scope_gl_framebuffers_t;
+
+extern SCOPE_GL_THREAD_LOCAL scope_gl_framebuffers_t* _scope_gl_framebuffers;
+void scope_gl_framebuffers_init(scope_gl_framebuffers_t* framebuffers);
+void scope_gl_framebuffers_destroy(scope_gl_framebuffers_t* framebuffers);
+void scope_gl_framebuffers_forget(scope_gl_framebuffers_t* framebuffers, GLuint object); /* a texture, SCOPE_GL_RENDERBUFFER(rb) or 0 */
+const scope_gl_framebuffer_entry_t* scope_gl_framebuffer_get(const GLuint* attachments, GLsizei count); /* never NULL, fbo 0 if not cached */
+const scope_gl_framebuffer_entry_t* _scope_gl_framebuffer_getv(GLsizei count, ...);                   /* count GLuint arguments */
+static inline void scope_gl_framebuffers_make_current(scope_gl_framebuffers_t* framebuffers) { _scope_gl_framebuffers = framebuffers; }
+
+/*
+** Bindless textures (ARB_bindless_texture): a residency manager hands out 64-bit texture handles and keeps their
+** textures resident. scope_glBindlessTextures(binding, first, count, textures) puts the handles into the current buffer
+** ring as a uniform block instead of binding texture units. Without the extension it binds the textures to the units
+** first .. first + count - 1 like scope_glBindTextures, so the program needs a variant for each path:
+**
+**   scope_gl_residency_t residency;
+**   int bindless = scope_gl_residency_init(&residency, 512 << 20); // budget in bytes, with the GL context current
+**   scope_gl_residency_make_current(&residency);
+**   if (bindless) { scope_gl_program_bindless(material_shader, 1); } // shadow mode: scope_glBindTexture2D becomes a no-op
+**   ...
+**   scope_glUseProgram(material_shader)
+**    scope_glBindlessTextures(1, 0, 3, material->textures) { glDrawElements(...); }
+**   scope_gl_residency_frame(&residency);                         // once per frame, evicts over the budget
+**
+**   // #extension GL_ARB_bindless_texture : require
+**   // layout(std140, binding = 1) uniform Textures { uvec4 handles[2]; }; // two handles per uvec4
+**   // ... texture(sampler2D(handles[0].zw), uv) for the second texture
+**
+** Textures are made resident on their first use and stay resident while scope_gl_texture_acquire() references them
+** or as long as the resident ones fit into the budget. scope_gl_residency_frame() makes the least recently used
+** unreferenced textures non-resident until they fit again, their next use makes them resident again. Textures used
+** in the last SCOPE_GL_RING_FRAMES frames are never evicted, the GPU may still sample them (the buffer ring keeps
+** the CPU at most that far ahead), so the budget can be exceeded for a while. The size of a
+** texture is estimated from level 0 (plus a third for mipmaps). Handles are kept until scope_gl_residency_destroy(),
+** e.g. after textures were deleted. Once the table is full further textures get handle 0 (counted in 'rejected').
+** NOTE: textures have to be GL_TEXTURE_2D without SCOPE_GL_DSA (for the size query), counts above
+** SCOPE_GL_MAX_MULTI_BIND are clamped. Works in all modes, the no-op binds need SCOPE_GL_SHADOW_STATE.
+*/
+#ifndef SCOPE_GL_MAX_RESIDENT
+#define SCOPE_GL_MAX_RESIDENT 256 /* power of two, textures with a handle */
+#endif
+
+typedef struct scope_gl_resident_t {
+    GLuint     texture;                                                      /* 0 for a free slot */
+    GLuint     refs;                                                         /* never evicted while referenced */
+    GLuint     frame;                                                        /* of the last use */
+    int        resident;
+    GLuint64   handle;
+    GLsizeiptr size;                                                         /* estimated bytes */
+} scope_gl_resident_t;
+
+typedef struct scope_gl_residency_t {
+    scope_gl_resident_t entries[SCOPE_GL_MAX_RESIDENT];                      /* open addressing */
+    GLuint              count;
+    GLuint              frame;
+    int                 bindless;                                            /* ARB_bindless_texture is available */
+    GLsizeiptr          budget;
+    GLsizeiptr          resident_size;
+    GLuint              evictions;
+    GLuint              rejected;                                            /* textures that found the table full */
+} scope_gl_residency_t;
+
+extern SCOPE_GL_THREAD_LOCAL scope_gl_residency_t* _scope_gl_residency;
+int scope_gl_residency_init(scope_gl_residency_t* residency, GLsizeiptr budget); /* 0 without ARB_bindless_texture */
+void scope_gl_residency_destroy(scope_gl_residency_t* residency);
+void scope_gl_residency_frame(scope_gl_residency_t* residency);
+GLuint64 scope_gl_texture_handle(GLuint texture);                                /* resident until evicted, 0 without the extension */
+GLuint64 scope_gl_texture_acquire(GLuint texture);                               /* resident until released */
+void scope_gl_texture_release(GLuint texture);
+int _scope_gl_texture_handles(GLsizei count, const GLuint* textures, GLuint64* handles);
+static inline void scope_gl_residency_make_current(scope_gl_residency_t* residency) { _scope_gl_residency = residency; }
+static inline int scope_gl_bindless_available(void) { return _scope_gl_residency && _scope_gl_residency->bindless; }
+
+/*
+** Buffer rings: one persistently and coherently mapped buffer (GL 4.4 buffer storage) split into SCOPE_GL_RING_FRAMES
+** segments. scope_gl_ring_alloc() hands out aligned ranges of the current segment, scope_gl_ring_frame() puts a fence
+** behind it and moves on to the next one. The CPU only waits if the GPU is still reading that segment, i.e. is more
+** than SCOPE_GL_RING_FRAMES - 1 frames behind (counted in 'stalls'). scope_glUniformBlock(binding, ptr, size) copies
+** size bytes into the current ring and binds them to the uniform block binding with glBindBufferRange:
+**
+**   scope_gl_ring_t ubo;
+**   scope_gl_ring_init(&ubo, GL_UNIFORM_BUFFER, 1 << 20);  // per frame, with the GL context current
+**   scope_gl_ring_make_current(&ubo);
+**   ...
+**   scope_glUniformBlock(0, &object->transform, sizeof(object->transform)) { glDrawArrays(...); }
+**   scope_gl_ring_frame(&ubo);                              // once per frame, e.g. after swapping
+**
+** The previous range of the binding is restored with SCOPE_GL_RESTORE_STATE, otherwise the binding is reset to 0. In
+** shadow mode it comes from the shadow copy (bindings below SCOPE_GL_MAX_BUFFER_BINDINGS), otherwise it is queried. Without a current ring or once the
+** segment is full nothing is bound (counted in 'overflows'). NOTE: the binds are not recorded by scope_glRecord().
+**
+** A ring created for GL_PIXEL_UNPACK_BUFFER stages texture uploads. scope_gl_ring_stage() hands out a range that can
+** be filled from any thread, scope_gl_ring_upload_2d() later issues glTexSubImage2D from it on the GL thread without
+** the driver copying client memory:
+**
+**   GLintptr offset;
+**   void* pixels = scope_gl_ring_stage(&pbo, w * h * 4, &offset);  // NULL when the segment is full
+**   ...                                                            // decode into pixels, e.g. on a worker
+**   scope_gl_ring_upload_2d(&pbo, offset, texture, 0, x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE);
+**
+** Staged ranges may be uploaded in a later frame, their segment is not reused until all its ranges were uploaded and
+** the fence behind the last upload has passed. Until then the frame that would reuse it gets no ring memory.
+*/
+#ifndef SCOPE_GL_RING_FRAMES
+#define SCOPE_GL_RING_FRAMES 3 /* segments, i.e. frames the GPU may be behind */
+#endif
+
+typedef struct scope_gl_ring_t {
+    GLuint         buffer;
+    unsigned char* memory;                                                   /* mapping of all segments, NULL if init failed */
+    GLsizeiptr     segment_size;
+    GLsizeiptr     alignment;                                                /* of the offsets handed out */
+    GLuint         segment;                                                  /* the one being filled */
+    GLsizeiptr     head;                                                     /* next free byte in it */
+    GLsync         fences[SCOPE_GL_RING_FRAMES];
+    GLuint         pending[SCOPE_GL_RING_FRAMES];                            /* staged ranges that were not uploaded yet */
+    GLuint         stalls;
+    GLuint         overflows;
+} scope_gl_ring_t;
+
+extern SCOPE_GL_THREAD_LOCAL scope_gl_ring_t* _scope_gl_ring;
+int scope_gl_ring_init(scope_gl_ring_t* ring, GLenum target, GLsizeiptr segment_size); /* 0 without buffer storage, target picks the alignment */
+void scope_gl_ring_destroy(scope_gl_ring_t* ring);
+void scope_gl_ring_frame(scope_gl_ring_t* ring);
+GLintptr scope_gl_ring_alloc(scope_gl_ring_t* ring, GLsizeiptr size, void** ptr); /* offset into ring->buffer or -1 */
+void* scope_gl_ring_stage(scope_gl_ring_t* ring, GLsizeiptr size, GLintptr* offset);
+void scope_gl_ring_upload_2d(scope_gl_ring_t* ring, GLintptr offset, GLuint texture, GLint level, GLint x, GLint y, GLsizei w, GLsizei h, GLenum format, GLenum type); /* GL_TEXTURE_2D */
+static inline void scope_gl_ring_make_current(scope_gl_ring_t* ring) { _scope_gl_ring = ring; }
+
+/*
+** Streaming buffers for geometry rewritten every frame (particles, UI). scope_gl_stream_map() hands out size bytes at
+** a multiple of stride in stream->buffer and the index of the first vertex there. Mapped ranges have to be unmapped
+** before the draw that reads them:
+**
+**   scope_gl_stream_t particles;
+**   scope_gl_stream_init(&particles, SCOPE_GL_STREAM_APPEND, 1 << 20);  // vertex array sources particles.buffer at 0
+**   ...
+**   GLint first;
+**   vertex_t* v = (vertex_t*) scope_gl_stream_map(&particles, n * sizeof(vertex_t), sizeof(vertex_t), &first);
+**   ...                                                                 // write n vertices
+**   scope_gl_stream_unmap(&particles);
+**   scope_glDrawArrays(GL_POINTS, first, n);
+**   scope_gl_stream_frame(&particles);                                  // once per frame
+**
+** SCOPE_GL_STREAM_ORPHAN     every map orphans the buffer (glBufferData with NULL), first is always 0
+** SCOPE_GL_STREAM_APPEND     ranges are mapped unsynchronized behind the previous ones, the buffer is only orphaned
+**                            once it is full
+** SCOPE_GL_STREAM_PERSISTENT a scope_gl_ring_t of size bytes per frame, nothing is mapped or unmapped per draw. Init
+**                            returns 0 without buffer storage, map returns NULL once the segment is full.
+**
+** The offset of the range is first * stride, a stride of 1 gives byte offsets, e.g. for index data.
+*/
+enum { SCOPE_GL_STREAM_ORPHAN, SCOPE_GL_STREAM_APPEND, SCOPE_GL_STREAM_PERSISTENT };
+
+typedef struct scope_gl_stream_t {
+    GLuint          buffer;                                                  /* ring.buffer in persistent mode */
+    int             mode;                                                    /* SCOPE_GL_STREAM_* */
+    GLsizeiptr      size;
+    GLsizeiptr      head;                                                    /* end of the last range */
+    int             mapped;
+    scope_gl_ring_t ring;                                                    /* persistent mode only */
+    GLuint          orphans;
+} scope_gl_stream_t;
+
+int scope_gl_stream_init(scope_gl_stream_t* stream, int mode, GLsizeiptr size);
+void scope_gl_stream_destroy(scope_gl_stream_t* stream);
+void* scope_gl_stream_map(scope_gl_stream_t* stream, GLsizeiptr size, GLsizei stride, GLint* first); /* NULL on failure */
+void scope_gl_stream_unmap(scope_gl_stream_t* stream);
+void scope_gl_stream_frame(scope_gl_stream_t* stream);
+
+#ifdef SCOPE_GL_SHADOW_STATE
+#include <stdint.h>
+#include <string.h>
+
+/* capabilities for glEnable/glDisable that are tracked with one bit each, others are queried with glIsEnabled */
+#define _SCOPE_GL_CAPS(X)                                                                     \
+        X(GL_BLEND)                     X(GL_CULL_FACE)                 X(GL_DEPTH_TEST)      \
+        X(GL_STENCIL_TEST)              X(GL_SCISSOR_TEST)              X(GL_DEPTH_CLAMP)     \
+        X(GL_POLYGON_OFFSET_FILL)       X(GL_POLYGON_OFFSET_LINE)       X(GL_POLYGON_OFFSET_POINT) \
+        X(GL_MULTISAMPLE)               X(GL_SAMPLE_ALPHA_TO_COVERAGE)  X(GL_SAMPLE_ALPHA_TO_ONE) \
+        X(GL_SAMPLE_COVERAGE)           X(GL_SAMPLE_MASK)               X(GL_FRAMEBUFFER_SRGB) \
+        X(GL_PRIMITIVE_RESTART)         X(GL_RASTERIZER_DISCARD)        X(GL_PROGRAM_POINT_SIZE) \
+        X(GL_TEXTURE_CUBE_MAP_SEAMLESS) X(GL_DITHER)                    X(GL_LINE_SMOOTH)     \
+        X(GL_POLYGON_SMOOTH)            X(GL_COLOR_LOGIC_OP)
+
+#define _SCOPE_GL_FIRST(first, ...)     first,
+#define _SCOPE_GL_CAP_FIRST(cap)        cap,
+#define _SCOPE_GL_TEX_ENUM(target, ...) _SCOPE_GL_TEX_##target,
+#define _SCOPE_GL_BUF_ENUM(target, ...) _SCOPE_GL_BUF_##target,
+#define _SCOPE_GL_CAP_ENUM(cap)         _SCOPE_GL_CAP_##cap,
+enum { _SCOPE_GL_TEXTURE_TARGETS(_SCOPE_GL_TEX_ENUM) _SCOPE_GL_TEXTURE_TARGET_COUNT };
+enum { _SCOPE_GL_BUFFER_TARGETS(_SCOPE_GL_BUF_ENUM)  _SCOPE_GL_BUFFER_TARGET_COUNT  };
+enum { _SCOPE_GL_CAPS(_SCOPE_GL_CAP_ENUM)            _SCOPE_GL_CAP_COUNT            };
+
+#ifndef SCOPE_GL_MAX_TEXTURE_UNITS
+#define SCOPE_GL_MAX_TEXTURE_UNITS   16 /* texture units above this are queried instead of tracked */
+#endif
+#ifndef SCOPE_GL_MAX_BUFFER_BINDINGS
+#define SCOPE_GL_MAX_BUFFER_BINDINGS 16 /* same for indexed buffer binding points */
+#endif
+#ifndef SCOPE_GL_MAX_PROGRAMS
+#define SCOPE_GL_MAX_PROGRAMS        32 /* programs with cached uniform locations, power of two */
+#endif
+#ifndef SCOPE_GL_MAX_BUILDING
+#define SCOPE_GL_MAX_BUILDING        64 /* programs linked in the background at a time, see scope_gl_program_building() */
+#endif
+#ifndef SCOPE_GL_MAX_BINDLESS
+#define SCOPE_GL_MAX_BINDLESS        16 /* programs marked with scope_gl_program_bindless() */
+#endif
+#ifndef SCOPE_GL_MAX_UNIFORMS
+#define SCOPE_GL_MAX_UNIFORMS        64 /* cached uniform names per program, power of two */
+#endif
+#ifndef SCOPE_GL_MAX_UNIFORM_LOCATIONS
+#define SCOPE_GL_MAX_UNIFORM_LOCATIONS 64 /* shadowed uniform values per program, multiple of 32, higher locations are read back */
+#endif
+#ifndef SCOPE_GL_MAX_VERTEX_ARRAYS
+#define SCOPE_GL_MAX_VERTEX_ARRAYS   64 /* unbound vertex arrays whose enabled attributes are remembered, power of two */
+#endif
+#ifndef SCOPE_GL_UNIFORM_STACK_SIZE
+#define SCOPE_GL_UNIFORM_STACK_SIZE  4096 /* words for old uniform values of all currently entered uniform scopes */
+#endif
+
+/* groups of tracked state, used for dirty tracking */
+enum {
+    SCOPE_GL_STATE_PROGRAM        = 1 << 0,
+    SCOPE_GL_STATE_VERTEX_ARRAY   = 1 << 1,
+    SCOPE_GL_STATE_TEXTURES       = 1 << 2,
+    SCOPE_GL_STATE_BUFFERS        = 1 << 3,
+    SCOPE_GL_STATE_SSBO           = 1 << 4,
+    SCOPE_GL_STATE_FRAMEBUFFER    = 1 << 5,
+    SCOPE_GL_STATE_RENDERBUFFER   = 1 << 6,
+    SCOPE_GL_STATE_CAPS           = 1 << 7,
+    SCOPE_GL_STATE_VIEWPORT       = 1 << 8,
+    SCOPE_GL_STATE_SCISSOR        = 1 << 9,
+    SCOPE_GL_STATE_CLEAR_COLOR    = 1 << 10,
+    SCOPE_GL_STATE_BLEND_FUNC     = 1 << 11,
+    SCOPE_GL_STATE_BLEND_EQUATION = 1 << 12,
+    SCOPE_GL_STATE_CULL_FACE      = 1 << 13,
+    SCOPE_GL_STATE_FRONT_FACE     = 1 << 14,
+    SCOPE_GL_STATE_SAMPLERS       = 1 << 15,
+    SCOPE_GL_STATE_UNIFORMS       = 1 << 16, /* shadowed uniform values, only for scope_glInvalidate/scope_glResync */
+    SCOPE_GL_STATE_VERTEX_ATTRIBS = 1 << 17, /* enabled attributes of all vertex arrays, see scope_glVertexAttribMask */
+    SCOPE_GL_STATE_ALL            = (1 << 18) - 1
+};
+
+/* all state that is tracked by the scopes */
+typedef struct scope_gl_state_t {
+    GLuint  program;
+    GLuint  vertex_array;
+    GLuint  active_texture;                                                  /* unit index, i.e. GL_TEXTUREi - GL_TEXTURE0 */
+    GLuint  textures[SCOPE_GL_MAX_TEXTURE_UNITS][_SCOPE_GL_TEXTURE_TARGET_COUNT];
+    GLuint  samplers[SCOPE_GL_MAX_TEXTURE_UNITS];
+    GLuint  buffers[_SCOPE_GL_BUFFER_TARGET_COUNT];
+    GLuint  ssbo_bindings[SCOPE_GL_MAX_BUFFER_BINDINGS];
+    GLint64 uniform_blocks[SCOPE_GL_MAX_BUFFER_BINDINGS][3];                 /* {buffer, offset, size}, part of BUFFERS, never pending */
+    GLuint  draw_framebuffer;
+    GLuint  read_framebuffer;
+    GLuint  renderbuffer;
+    GLuint  caps;                                                            /* one bit per entry in _SCOPE_GL_CAPS */
+    GLfloat viewport[SCOPE_GL_MAX_VIEWPORTS][4];                              /* per index, see _scope_gl_set_rects() */
+    GLint   scissor[SCOPE_GL_MAX_VIEWPORTS][4];
+    GLuint  viewports, scissors;                                             /* indices from here on equal index 0 */
+    GLfloat clear_color[4];
+    GLenum  blend_src, blend_dst;
+    GLenum  blend_equation;
+    GLenum  cull_face;
+    GLenum  front_face;
+} scope_gl_state_t;
+
+/* uniform locations are cached by the address of the name, so names have to be string literals (or otherwise stay
+ * valid and unchanged for as long as the program lives) */
+typedef struct scope_gl_uniform_t {
+    const char* name;
+    GLint       location;
+} scope_gl_uniform_t;
+
+/* uniform values are stored as 32-bit words (GLfloat or GLint) indexed by location, one mat4 worth per location */
+typedef struct scope_gl_program_t {
+    GLuint             id;                                                   /* 0 marks a free slot */
+    scope_gl_uniform_t uniforms[SCOPE_GL_MAX_UNIFORMS];
+    GLuint             known[SCOPE_GL_MAX_UNIFORM_LOCATIONS / 32];          /* one bit per location with a valid value */
+    GLuint             values[SCOPE_GL_MAX_UNIFORM_LOCATIONS][16];
+} scope_gl_program_t;
+
+/*
+** Command buffers (lazy mode only): draws inside scope_glRecord() are not issued but appended to a command buffer
+** together with the state and uniform values the scopes asked for. scope_gl_cmdbuf_submit() sorts them by state
+** (program, textures, vertex array) and replays them, so draws that share state end up next to each other and the
+** binds between them disappear:
+**
+**   static char memory[1 << 20];
+**   scope_gl_cmdbuf_t cmds;
+**   scope_gl_cmdbuf_init(&cmds, memory, sizeof(memory));
+**   scope_glRecord(&cmds) {
+**       for (int i = 0; i < n; i++) scope_glUseProgram(obj[i].shader) scope_glBindTexture2D(obj[i].tex) { scope_glDrawArrays(...); }
+**   }
+**   scope_gl_cmdbuf_submit(&cmds); // also resets it
+**
+** Order is kept where it matters: a clear or a change of the draw framebuffer starts a new pass and nothing is moved
+** across passes, draws with GL_BLEND enabled stay in recording order behind the other draws of their pass.
+** NOTE: only draws, clears, tracked state and shadowed uniforms are recorded, anything else inside scope_glRecord()
+** (buffer uploads, untracked targets, ...) happens immediately. Vertex and index data has to stay unchanged until
+** the submit. Commands that do not fit into the memory are dropped and counted in 'dropped'.
+*/
+enum { _SCOPE_GL_CMD_DRAW_ARRAYS, _SCOPE_GL_CMD_DRAW_ELEMENTS, _SCOPE_GL_CMD_CLEAR };
+
+/* a recorded uniform scope, prev is the enclosing one. values holds count*comps new values followed by the old ones */
+typedef struct scope_gl_uniform_cmd_t {
+    const struct scope_gl_uniform_cmd_t* prev;
+    void        (*upload)(GLint loc, GLsizei count, const void* v);
+    GLuint        program;
+    GLint         location;
+    GLsizei       count;
+    int           comps;
+    GLint         top;                                                       /* uniform stack position, identifies the scope on pop */
+    int           depth;
+    const GLuint* values;
+} scope_gl_uniform_cmd_t;
+
+typedef struct scope_gl_cmd_t {
+    uint64_t                      key;                                       /* pass | blend | program | textures | vertex array */
+    const scope_gl_state_t*       state;
+    const scope_gl_uniform_cmd_t* uniforms;
+    int                           kind;                                      /* _SCOPE_GL_CMD_* */
+    GLenum                        mode;                                      /* mask for clears */
+    GLint                         first;
+    GLsizei                       count;
+    GLenum                        type;
+    const void*                   indices;
+} scope_gl_cmd_t;
+
+typedef struct scope_gl_cmdbuf_t {
+    unsigned char*                memory;                                    /* state and uniforms grow from the start, */
+    size_t                        size, head;                                /* commands from the end */
+    GLuint                        count;
+    GLuint                        dropped;
+    /* while recording */
+    const scope_gl_state_t*       state;                                     /* last snapshot, reused until a scope changes state */
+    uint64_t                      state_key;
+    const scope_gl_uniform_cmd_t* uniforms;                                  /* innermost recorded uniform scope */
+    GLuint                        pass;
+    GLuint                        framebuffer;
+    GLuint                        dirty;                                     /* ctx->dirty from before the recording */
+} scope_gl_cmdbuf_t;
+
+/*
+** Draw batches (lazy mode only): scope_glDrawArrays/scope_glDrawElements inside scope_glDrawBatch() are not issued but
+** appended as DrawArraysIndirectCommand/DrawElementsIndirectCommand to the batch. The batch goes out as one
+** glMultiDrawArraysIndirect/glMultiDrawElementsIndirect from a streamed indirect buffer before tracked state changes,
+** before anything else reaches GL through the scopes (uploads, scope_glFlushState(), ...), or when the region closes:
+**
+**   scope_gl_batch_t batch;
+**   scope_gl_batch_init(&batch, 1 << 16);                       // bytes of commands per frame
+**   ...
+**   scope_glUseProgram(sprites) scope_glBindVertexArray(quads) scope_glDrawBatch(&batch) {
+**       for (int i = 0; i < n; i++) {
+**           per_draw[scope_gl_batch_draw_id(&batch)] = sprite[i].transform; // e.g. a persistently mapped SSBO
+**           scope_glDrawArrays(GL_TRIANGLES, 6 * i, 6);
+**       }
+**   }
+**   scope_gl_batch_frame(&batch);                                // once per frame
+**
+** A draw continues the batch if no tracked state changed since the previous one and it has the same primitive mode
+** (and index type), otherwise it starts a new one. Draws get the index in their batch as gl_DrawID and as base instance,
+** i.e. gl_BaseInstance or an attribute with divisor 1 read per-draw data without GL 4.6. Indices are offsets into the
+** element array buffer. Batches that do not fit into the ring are drawn one by one (counted in ring.overflows).
+** NOTE: direct gl* calls inside need a scope_glFlushState() first, as everywhere in lazy mode.
+*/
+#ifndef SCOPE_GL_MAX_BATCH
+#define SCOPE_GL_MAX_BATCH 256 /* draws per multi-draw */
+#endif
+
+typedef struct scope_gl_batch_t {
+    scope_gl_ring_t ring;                                                    /* GL_DRAW_INDIRECT_BUFFER */
+    GLuint          commands[SCOPE_GL_MAX_BATCH][5];                         /* Draw{Arrays,Elements}IndirectCommand */
+    GLsizei         count;
+    GLenum          mode;
+    GLenum          type;                                                    /* of the indices, 0 for glDrawArrays */
+    GLuint          draws;
+    GLuint          submits;                                                 /* multi-draws issued */
+} scope_gl_batch_t;
+
+/* everything the scopes keep per GL context */
+typedef struct scope_gl_context_t {
+    scope_gl_state_t   gl;    /* what the GL context currently has */
+    scope_gl_state_t   want;  /* lazy mode: what the scopes asked for so far */
+    GLuint             dirty; /* lazy mode: SCOPE_GL_STATE_* groups that differ between want and gl (since the last recorded draw while recording) */
+    GLuint             unknown; /* SCOPE_GL_STATE_* groups dropped by scope_glInvalidate(), queried again on their next use */
+    scope_gl_cmdbuf_t* recording;
+    scope_gl_batch_t*  batching;
+    scope_gl_program_t programs[SCOPE_GL_MAX_PROGRAMS];
+    GLuint             uniform_stack[SCOPE_GL_UNIFORM_STACK_SIZE];
+    GLint              uniform_top;
+    GLuint             building[SCOPE_GL_MAX_BUILDING][2];                  /* {program, placeholder} of programs still linking */
+    GLuint             building_count;
+    GLuint             bindless[SCOPE_GL_MAX_BINDLESS];                     /* programs that take their textures as handles */
+    GLuint             bindless_count;
+    GLuint             vertex_attribs;                                      /* enabled attributes of the vertex array the GL context has bound */
+    GLuint             vertex_arrays[SCOPE_GL_MAX_VERTEX_ARRAYS][2];        /* {vertex array, enabled attributes} of unbound ones, open addressing */
+} scope_gl_context_t;
+
+extern SCOPE_GL_THREAD_LOCAL scope_gl_context_t* _scope_gl_ctx; /* current context of this thread */
+void scope_gl_context_sync(scope_gl_context_t* ctx);  /* query all tracked state from the current GL context, drops all caches */
+void scope_gl_invalidate_program(GLuint program);     /* call after (re)linking a program, drops its cached uniform locations and values */
+void scope_gl_forget_uniform_names(void);              /* call after unloading code whose string literals named uniforms (hot reload), keeps the values */
+void scope_gl_program_building(GLuint program, GLuint placeholder); /* program links in the background (KHR_parallel_shader_compile), scopes bind placeholder instead */
+void scope_gl_program_ready(GLuint program);          /* done linking (or deleted), scopes bind it again */
+void scope_gl_program_bindless(GLuint program, int bindless); /* scope_glBindTexture2D scopes are no-ops while program is bound, see scope_gl_residency_t */
+void _scope_gl_resync(GLuint mask);
+scope_gl_program_t* _scope_gl_program(GLuint program);
+GLint _scope_gl_uniform_location_miss(scope_gl_program_t* prog, const char* name);
+GLint _scope_gl_uniform_push(GLint location, GLsizei count, int comps, int is_int, const void* values, int* changed);
+const void* _scope_gl_uniform_pop(GLint location, GLsizei count, int comps, GLint top);
+void _scope_gl_apply_state(scope_gl_context_t* ctx, const scope_gl_state_t* want, GLuint mask);
+void _scope_gl_switch_vertex_attribs(scope_gl_context_t* ctx, GLuint old_vao, GLuint vao);
+void scope_gl_cmdbuf_init(scope_gl_cmdbuf_t* cmdbuf, void* memory, size_t size); /* memory has to be 8-byte aligned */
+void scope_gl_cmdbuf_reset(scope_gl_cmdbuf_t* cmdbuf);
+void scope_gl_cmdbuf_submit(scope_gl_cmdbuf_t* cmdbuf);                        /* issues the recorded commands sorted by state, then resets */
+scope_gl_cmdbuf_t* _scope_gl_begin_record(scope_gl_cmdbuf_t* cmdbuf);
+void _scope_gl_end_record(scope_gl_cmdbuf_t* cmdbuf);
+void _scope_gl_record(int kind, GLenum mode, GLint first, GLsizei count, GLenum type, const void* indices);
+void _scope_gl_record_uniform(GLint location, GLsizei count, int comps, const void* values, GLint top, void (*upload)(GLint, GLsizei, const void*));
+void _scope_gl_record_uniform_pop(GLint top);
+int scope_gl_batch_init(scope_gl_batch_t* batch, GLsizeiptr size);
+void scope_gl_batch_destroy(scope_gl_batch_t* batch);
+void scope_gl_batch_frame(scope_gl_batch_t* batch);
+void _scope_gl_batch_submit(scope_gl_batch_t* batch);
+scope_gl_batch_t* _scope_gl_begin_batch(scope_gl_batch_t* batch);
+void _scope_gl_end_batch(scope_gl_batch_t* batch, scope_gl_batch_t* prev);
+static inline void scope_gl_make_current(scope_gl_context_t* ctx) { _scope_gl_ctx = ctx; } /* call whenever the GL context of this thread changes */
+static inline scope_gl_context_t* scope_gl_current_context(void)  { return _scope_gl_ctx; }
+/* gl_DrawID of the next draw, valid if it continues the batch */
+static inline GLuint scope_gl_batch_draw_id(const scope_gl_batch_t* batch) {
+    return (batch->count < SCOPE_GL_MAX_BATCH && !_scope_gl_ctx->dirty) ? (GLuint) batch->count : 0;
+}
+
+/* same as SDL_GL_MakeCurrent(), on success ctx becomes the current scope context of this thread */
+#define scope_SDL_GL_MakeCurrent(window, glcontext, ctx) \
+    (SDL_GL_MakeCurrent(window, glcontext) == 0 ? (scope_gl_make_current(ctx), 0) : -1)
+
+#define _SCOPE_GL_TEX_CASE(target, ...) case target: return _SCOPE_GL_TEX_##target;
+#define _SCOPE_GL_BUF_CASE(target, ...) case target: return _SCOPE_GL_BUF_##target;
+#define _SCOPE_GL_CAP_CASE(cap)         case cap:    return _SCOPE_GL_CAP_##cap;
+static inline int _scope_gl_texture_target_index(GLenum target) { switch (target) { _SCOPE_GL_TEXTURE_TARGETS(_SCOPE_GL_TEX_CASE) default: return -1; } }
+static inline int _scope_gl_buffer_target_index(GLenum target)  { switch (target) { _SCOPE_GL_BUFFER_TARGETS(_SCOPE_GL_BUF_CASE)  default: return -1; } }
+static inline int _scope_gl_cap_index(GLenum cap)               { switch (cap)    { _SCOPE_GL_CAPS(_SCOPE_GL_CAP_CASE)            default: return -1; } }
+
+static const GLenum _scope_gl_texture_targets[] = { _SCOPE_GL_TEXTURE_TARGETS(_SCOPE_GL_FIRST) };
+static const GLenum _scope_gl_buffer_targets[]  = { _SCOPE_GL_BUFFER_TARGETS(_SCOPE_GL_FIRST)  };
+static const GLenum _scope_gl_caps[]            = { _SCOPE_GL_CAPS(_SCOPE_GL_CAP_FIRST)        };
+
+/* redundant state changes are skipped, define SCOPE_GL_NO_REDUNDANCY_CHECK to always issue the gl* call, e.g. when
+ * debugging with a frame capture tool */
+#ifdef SCOPE_GL_NO_REDUNDANCY_CHECK
+  #define _scope_gl_changed(differs) ((void)(differs), 1)
+#else
+  #define _scope_gl_changed(differs) (differs)
+#endif
+
+/* in lazy mode the setters only record the desired state in ctx->want and mark its group dirty, the gl* calls are
+ * issued by _scope_gl_flush() right before the next draw. Otherwise ctx->want is unused and the call is made directly */
+#define _scope_gl_stat_group(field, group) _scope_gl_stat(field, _scope_gl_ctz(group))
+#define _scope_gl_apply_now(group, differs, call) do { if (_scope_gl_changed(differs)) { _scope_gl_stat_group(sets, group); call; } else { _scope_gl_stat_group(skipped, group); } } while (0)
+#ifdef SCOPE_GL_LAZY_STATE
+  #define _scope_gl_tracked() (&_scope_gl_ctx->want)
+  #define _scope_gl_apply(group, differs, call) do { if (_scope_gl_changed(differs)) { _scope_gl_ctx->dirty |= (group); } else { _scope_gl_stat_group(skipped, group); } } while (0)
+#else
+  #define _scope_gl_tracked() (&_scope_gl_ctx->gl)
+  #define _scope_gl_apply(group, differs, call) _scope_gl_apply_now(group, differs, call)
+#endif
+
+/* while recording, draws and uniform uploads go into the command buffer, while batching draws go into the batch */
+#ifdef SCOPE_GL_LAZY_STATE
+  #define _scope_gl_recording() (_scope_gl_ctx->recording != NULL)
+  #define _scope_gl_draw(record, call) ((_scope_gl_recording() || _scope_gl_ctx->batching) ? (record) : (scope_glFlushState(), (call)))
+#else
+  #define _scope_gl_recording() 0
+  #define _scope_gl_draw(record, call) (call)
+#endif
+
+/* applies the groups in mask of the lazily recorded state, a no-op in all other modes */
+static inline void _scope_gl_flush(GLuint mask) {
+#ifdef SCOPE_GL_LAZY_STATE
+    scope_gl_context_t* ctx = _scope_gl_ctx;
+    if (ctx->batching && ctx->batching->count) { _scope_gl_batch_submit(ctx->batching); } /* GL is about to change */
+    if ((ctx->dirty & mask) && !ctx->recording) {
+        _scope_gl_apply_state(ctx, &ctx->want, ctx->dirty & mask);
+        ctx->dirty &= ~mask;
+    }
+#else
+    (void) mask;
+#endif
+}
+
+/* tracked state for a setter of group, groups dropped by scope_glInvalidate() are queried first */
+static inline scope_gl_state_t* _scope_gl_known(GLuint group) {
+    if (_scope_gl_ctx->unknown & group) { _scope_gl_resync(_scope_gl_ctx->unknown & group); }
+    return _scope_gl_tracked();
+}
+
+/* NOTE: pending lazy state of the groups is dropped as well, so flush before handing over to foreign code */
+static inline void _scope_gl_invalidate(GLuint mask) {
+    _scope_gl_ctx->unknown |= mask;
+    if (mask & SCOPE_GL_STATE_VERTEX_ATTRIBS) { memset(_scope_gl_ctx->vertex_arrays, 0, sizeof(_scope_gl_ctx->vertex_arrays)); }
+#ifdef SCOPE_GL_LAZY_STATE
+    _scope_gl_ctx->dirty &= ~mask;
+#endif
+}
+
+static inline unsigned _scope_gl_hash_ptr(const void* ptr) { uintptr_t p = (uintptr_t) ptr; return (unsigned) ((p >> 3) ^ (p >> 11)); }
+
+/* location of uniform 'name' in the current program, only asks the driver the first time */
+static inline GLint _scope_gl_uniform_location(const char* name) {
+    GLuint program = _scope_gl_known(SCOPE_GL_STATE_PROGRAM)->program;
+    if (program == 0) { return -1; }
+    scope_gl_program_t* prog = _scope_gl_program(program);
+    scope_gl_uniform_t* u = &prog->uniforms[_scope_gl_hash_ptr(name) & (SCOPE_GL_MAX_UNIFORMS - 1)];
+    if (u->name == name) { return u->location; }
+    return _scope_gl_uniform_location_miss(prog, name);
+}
+
+/* _scope_gl_uniform_push_<ext>() and _scope_gl_uniform_pop_<ext>(), only upload if the shadowed value changes.
+ * NOTE: glUniform* needs the program bound, so in lazy mode an upload flushes the program binding */
+#define _SCOPE_GL_UNIFORM_SHADOW(ext, comps, is_int, upload)                                                   \
+    static inline GLint _scope_gl_uniform_push_##ext(GLint loc, GLsizei count, const void* v) {                \
+        int changed;                                                                                           \
+        GLint top = _scope_gl_uniform_push(loc, count, comps, is_int, v, &changed);                            \
+        if (changed && _scope_gl_recording()) { _scope_gl_record_uniform(loc, count, comps, v, top, _scope_gl_upload_##ext); } \
+        else if (changed) { _scope_gl_flush(SCOPE_GL_STATE_PROGRAM); _scope_gl_stat(sets, SCOPE_GL_STAT_UNIFORMS); upload; } \
+        else { _scope_gl_stat(skipped, SCOPE_GL_STAT_UNIFORMS); }                                              \
+        return top;                                                                                            \
+    }                                                                                                          \
+    static inline void _scope_gl_uniform_pop_##ext(GLint loc, GLsizei count, GLint top) {                      \
+        const void* v = _scope_gl_uniform_pop(loc, count, comps, top);                                         \
+        if (_scope_gl_recording()) { _scope_gl_record_uniform_pop(top); }                                      \
+        else if (v) { _scope_gl_flush(SCOPE_GL_STATE_PROGRAM); _scope_gl_stat(sets, SCOPE_GL_STAT_UNIFORMS); upload; } \
+        else { _scope_gl_stat(skipped, SCOPE_GL_STAT_UNIFORMS); }                                              \
+    }
+_SCOPE_GL_UNIFORM_KINDS(_SCOPE_GL_UNIFORM_SHADOW)
+
+/* placeholder of a program that is still linking, glUseProgram on it would wait for the link */
+static inline GLuint _scope_gl_ready_program(GLuint id) {
+    scope_gl_context_t* ctx = _scope_gl_ctx;
+    for (GLuint i = 0; i < ctx->building_count; i++) { if (ctx->building[i][0] == id) { return ctx->building[i][1]; } }
+    return id;
+}
+
+/* the bound program reads its textures from bindless handles */
+static inline int _scope_gl_bindless_program(GLuint program) {
+    scope_gl_context_t* ctx = _scope_gl_ctx;
+    for (GLuint i = 0; i < ctx->bindless_count; i++) { if (ctx->bindless[i] == program) { return 1; } }
+    return 0;
+}
+
+/* setters: apply (or record) the new state, update the shadow copy and hand back the previous value */
+static inline GLuint _scope_gl_use_program(GLuint id) {
+    if (_scope_gl_ctx->building_count) { id = _scope_gl_ready_program(id); }
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_PROGRAM);
+    GLuint old = gl->program;
+    _scope_gl_apply(SCOPE_GL_STATE_PROGRAM, old != id, glUseProgram(id));
+    gl->program = id;
+    return old;
+}
+
+static inline GLuint _scope_gl_bind_vertex_array(GLuint vao) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_VERTEX_ARRAY);
+    GLuint old = gl->vertex_array;
+    _scope_gl_apply(SCOPE_GL_STATE_VERTEX_ARRAY, old != vao, (glBindVertexArray(vao), _scope_gl_switch_vertex_attribs(_scope_gl_ctx, old, vao)));
+    gl->vertex_array = vao;
+    return old;
+}
+
+/* the enabled attributes belong to the vertex array the GL context has bound, so in lazy mode its binding is
+ * flushed and the mask is applied right away (like uniform uploads). Only the attributes that differ are toggled.
+ * NOTE: not recorded by scope_glRecord(), and direct glEnableVertexAttribArray calls or deleted vertex arrays need
+ * scope_glInvalidate(SCOPE_GL_STATE_VERTEX_ATTRIBS), which forgets the masks of all vertex arrays */
+static inline GLuint _scope_gl_vertex_attrib_mask(GLuint mask) {
+    scope_gl_context_t* ctx = _scope_gl_ctx;
+    _scope_gl_known(SCOPE_GL_STATE_VERTEX_ARRAY);
+    _scope_gl_flush(SCOPE_GL_STATE_VERTEX_ARRAY);
+    if (ctx->unknown & SCOPE_GL_STATE_VERTEX_ATTRIBS) { /* vertex array not seen before */
+        ctx->vertex_attribs = ctx->gl.vertex_array ? _scope_gl_query_vertex_attribs() : 0;
+        ctx->unknown &= ~SCOPE_GL_STATE_VERTEX_ATTRIBS;
+        _scope_gl_stat(queries, SCOPE_GL_STAT_VERTEX_ATTRIBS);
+    }
+    GLuint old = ctx->vertex_attribs;
+    if (_scope_gl_changed(old != mask)) { _scope_gl_toggle_vertex_attribs(old ^ mask, mask); } else { _scope_gl_stat(skipped, SCOPE_GL_STAT_VERTEX_ATTRIBS); }
+    ctx->vertex_attribs = mask;
+    return old;
+}
+
+static inline GLuint _scope_gl_bind_texture(GLenum target, GLuint texture) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_TEXTURES);
+    int t = _scope_gl_texture_target_index(target);
+    if (t < 0 || gl->active_texture >= SCOPE_GL_MAX_TEXTURE_UNITS) { /* not tracked */
+        GLint old;
+        _scope_gl_flush(SCOPE_GL_STATE_TEXTURES);
+        glGetIntegerv(_scope_gl_map_texture_target_to_binding(target), &old);
+        _scope_gl_stat(queries, SCOPE_GL_STAT_TEXTURES);
+        _scope_gl_apply_now(SCOPE_GL_STATE_TEXTURES, (GLuint) old != texture, glBindTexture(target, texture));
+        return (GLuint) old;
+    }
+    GLuint old = gl->textures[gl->active_texture][t];
+    _scope_gl_apply(SCOPE_GL_STATE_TEXTURES, old != texture, glBindTexture(target, texture));
+    gl->textures[gl->active_texture][t] = texture;
+    return old;
+}
+
+/* scope_glBindTexture2D draw scopes only, edits and uploads always bind the object they modify */
+static inline GLuint _scope_gl_bind_draw_texture(GLuint texture) {
+    if (_scope_gl_ctx->bindless_count && _scope_gl_bindless_program(_scope_gl_known(SCOPE_GL_STATE_PROGRAM)->program)) { /* NOTE: a no-op bind */
+        scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_TEXTURES);
+        _scope_gl_stat(skipped, SCOPE_GL_STAT_TEXTURES);
+        return gl->active_texture < SCOPE_GL_MAX_TEXTURE_UNITS ? gl->textures[gl->active_texture][_SCOPE_GL_TEX_GL_TEXTURE_2D] : texture;
+    }
+    return _scope_gl_bind_texture(GL_TEXTURE_2D, texture);
+}
+
+static inline GLuint _scope_gl_bind_buffer(GLenum target, GLuint buffer) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_BUFFERS);
+    int t = _scope_gl_buffer_target_index(target);
+    if (t < 0) { /* not tracked */
+        GLint old;
+        _scope_gl_flush(SCOPE_GL_STATE_VERTEX_ARRAY); /* NOTE: only untracked buffer target is part of the vao */
+        glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &old);
+        _scope_gl_stat(queries, SCOPE_GL_STAT_BUFFERS);
+        _scope_gl_apply_now(SCOPE_GL_STATE_BUFFERS, (GLuint) old != buffer, glBindBuffer(target, buffer));
+        return (GLuint) old;
+    }
+    GLuint old = gl->buffers[t];
+    _scope_gl_apply(SCOPE_GL_STATE_BUFFERS, old != buffer, glBindBuffer(target, buffer));
+    gl->buffers[t] = buffer;
+    return old;
+}
+
+/* binds ssbo to the indexed binding and (as glBindBufferBase does) to the generic binding, old = {indexed, generic} */
+static inline void _scope_gl_bind_ssbo(GLuint ssbo, GLuint binding, GLuint old[2]) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_SSBO | SCOPE_GL_STATE_BUFFERS);
+    if (binding >= SCOPE_GL_MAX_BUFFER_BINDINGS) { /* not tracked */
+        _scope_gl_flush(SCOPE_GL_STATE_SSBO);
+        if (old) { GLint b; glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, binding, &b); old[0] = (GLuint) b; old[1] = gl->buffers[_SCOPE_GL_BUF_GL_SHADER_STORAGE_BUFFER]; _scope_gl_stat(queries, SCOPE_GL_STAT_SSBO); }
+        _scope_gl_stat(sets, SCOPE_GL_STAT_SSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, ssbo);
+        _scope_gl_ctx->gl.buffers[_SCOPE_GL_BUF_GL_SHADER_STORAGE_BUFFER] = ssbo;
+        gl->buffers[_SCOPE_GL_BUF_GL_SHADER_STORAGE_BUFFER] = ssbo;
+        return;
+    }
+    if (old) { old[0] = gl->ssbo_bindings[binding]; old[1] = gl->buffers[_SCOPE_GL_BUF_GL_SHADER_STORAGE_BUFFER]; }
+    int same = (gl->ssbo_bindings[binding] == ssbo) && (gl->buffers[_SCOPE_GL_BUF_GL_SHADER_STORAGE_BUFFER] == ssbo);
+    _scope_gl_apply(SCOPE_GL_STATE_SSBO, !same, glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, ssbo));
+    gl->ssbo_bindings[binding] = ssbo;
+    gl->buffers[_SCOPE_GL_BUF_GL_SHADER_STORAGE_BUFFER] = ssbo;
+}
+
+static inline GLboolean _scope_gl_enable(GLenum cap, GLboolean enable) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_CAPS);
+    int c = _scope_gl_cap_index(cap);
+    if (c < 0) { /* not tracked */
+        GLboolean old = glIsEnabled(cap);
+        _scope_gl_stat(queries, SCOPE_GL_STAT_CAPS);
+        _scope_gl_apply_now(SCOPE_GL_STATE_CAPS, old != (enable != 0), if (enable) { glEnable(cap); } else { glDisable(cap); });
+        return old;
+    }
+    GLboolean old = (GLboolean) ((gl->caps >> c) & 1);
+    _scope_gl_apply(SCOPE_GL_STATE_CAPS, old != (enable != 0), if (enable) { glEnable(cap); } else { glDisable(cap); });
+    gl->caps = (gl->caps & ~(1u << c)) | ((GLuint) (enable != 0) << c);
+    return old;
+}
+
+/* GL_FRAMEBUFFER binds both draw and read framebuffer and returns the old draw framebuffer */
+static inline GLuint _scope_gl_bind_framebuffer(GLenum target, GLuint fbo) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_FRAMEBUFFER);
+    GLuint old = (target == GL_READ_FRAMEBUFFER) ? gl->read_framebuffer : gl->draw_framebuffer;
+    int same = (target == GL_READ_FRAMEBUFFER || gl->draw_framebuffer == fbo) &&
+               (target == GL_DRAW_FRAMEBUFFER || gl->read_framebuffer == fbo);
+    _scope_gl_apply(SCOPE_GL_STATE_FRAMEBUFFER, !same, glBindFramebuffer(target, fbo));
+    if (target != GL_READ_FRAMEBUFFER) { gl->draw_framebuffer = fbo; }
+    if (target != GL_DRAW_FRAMEBUFFER) { gl->read_framebuffer = fbo; }
+    return old;
+}
+
+static inline GLuint _scope_gl_bind_renderbuffer(GLenum target, GLuint renderbuffer) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_RENDERBUFFER);
+    GLuint old = gl->renderbuffer;
+    (void) target; /* NOTE: GL_RENDERBUFFER is the only target */
+    _scope_gl_apply(SCOPE_GL_STATE_RENDERBUFFER, old != renderbuffer, glBindRenderbuffer(target, renderbuffer));
+    gl->renderbuffer = renderbuffer;
+    return old;
+}
+
+/* glViewport/glScissor set every index, so only the first n rects of an array are kept and the ones after them equal
+ * rect 0, which keeps the plain scopes one compare. A rect is GLfloat[4] or GLint[4], both 16 bytes */
+static inline const void* _scope_gl_rect(const void* rects, GLuint n, GLuint i) { return (const unsigned char*) rects + (i < n ? i : 0) * 16; }
+
+/* sets rects first .. first + count - 1 to values, old gets the previous ones. Without values rect 0 becomes unset and
+ * the others rect 0, like _scope_gl_unset_viewports(). Returns whether any changed. NOTE: count is clamped already */
+static inline int _scope_gl_set_rects(void* rects, GLuint* n, GLuint first, GLsizei count, const void* values, const void* unset, void* old) {
+    unsigned char* r = (unsigned char*) rects;
+    if (count <= 0) { return 0; }
+    GLuint own = (first == 0) ? SCOPE_GL_MAX_VIEWPORTS : first + (GLuint) count; /* the rects after it stop following rect 0 */
+    for (GLuint i = (*n > 1) ? *n : 1; i < own; i++) { memcpy(r + i * 16, r, 16); }
+    if (*n < own) { *n = own; }
+    int differs = 0;
+    for (GLsizei i = 0; i < count; i++) {
+        unsigned char* d = r + (first + (GLuint) i) * 16;
+        const void* v = values ? (const unsigned char*) values + i * 16 : (first + (GLuint) i == 0) ? unset : r;
+        if (old) { memcpy((unsigned char*) old + i * 16, d, 16); }
+        differs |= memcmp(d, v, 16) != 0;
+        memcpy(d, v, 16);
+    }
+    return differs;
+}
+
+/* all SCOPE_GL_MAX_VIEWPORTS rects of an array with n own ones */
+static inline void _scope_gl_fill_rects(void* dst, const void* src, GLuint n) {
+    for (GLuint i = 0; i < SCOPE_GL_MAX_VIEWPORTS; i++) { memcpy((unsigned char*) dst + i * 16, _scope_gl_rect(src, n, i), 16); }
+}
+
+static inline int _scope_gl_rects_differ(const void* a, GLuint na, const void* b, GLuint nb) {
+    for (GLuint i = 0; i < na || i < nb || i == 0; i++) {
+        if (memcmp(_scope_gl_rect(a, na, i), _scope_gl_rect(b, nb, i), 16) != 0) { return 1; }
+    }
+    return 0;
+}
+
+static inline void _scope_gl_viewport(GLint x, GLint y, GLsizei w, GLsizei h, GLint old[4]) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_VIEWPORT);
+    GLfloat* v = gl->viewport[0];
+    if (old) { old[0] = (GLint) v[0]; old[1] = (GLint) v[1]; old[2] = (GLint) v[2]; old[3] = (GLint) v[3]; }
+    _scope_gl_apply(SCOPE_GL_STATE_VIEWPORT, gl->viewports > 1 || v[0] != x || v[1] != y || v[2] != w || v[3] != h, glViewport(x, y, w, h));
+    v[0] = (GLfloat) x; v[1] = (GLfloat) y; v[2] = (GLfloat) w; v[3] = (GLfloat) h;
+    gl->viewports = 1;
+}
+
+static inline void _scope_gl_scissor(GLint x, GLint y, GLsizei w, GLsizei h, GLint old[4]) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_SCISSOR);
+    GLint* s = gl->scissor[0];
+    if (old) { old[0] = s[0]; old[1] = s[1]; old[2] = s[2]; old[3] = s[3]; }
+    _scope_gl_apply(SCOPE_GL_STATE_SCISSOR, gl->scissors > 1 || s[0] != x || s[1] != y || s[2] != w || s[3] != h, glScissor(x, y, w, h));
+    s[0] = x; s[1] = y; s[2] = w; s[3] = h;
+    gl->scissors = 1;
+}
+
+static inline void _scope_gl_viewport_array(GLuint first, GLsizei count, const GLfloat* rects, GLfloat (*old)[4]) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_VIEWPORT);
+    int differs = _scope_gl_set_rects(gl->viewport, &gl->viewports, first, count, rects, _scope_gl_unset_viewport, old);
+    _scope_gl_apply(SCOPE_GL_STATE_VIEWPORT, differs, glViewportArrayv(first, count, gl->viewport[first]));
+}
+
+static inline void _scope_gl_scissor_array(GLuint first, GLsizei count, const GLint* rects, GLint (*old)[4]) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_SCISSOR);
+    int differs = _scope_gl_set_rects(gl->scissor, &gl->scissors, first, count, rects, _scope_gl_unset_scissor, old);
+    _scope_gl_apply(SCOPE_GL_STATE_SCISSOR, differs, glScissorArrayv(first, count, gl->scissor[first]));
+}
+
+static inline void _scope_gl_clear_color(GLfloat r, GLfloat g, GLfloat b, GLfloat a, GLfloat old[4]) {
+    GLfloat* c = _scope_gl_known(SCOPE_GL_STATE_CLEAR_COLOR)->clear_color;
+    if (old) { old[0] = c[0]; old[1] = c[1]; old[2] = c[2]; old[3] = c[3]; }
+    _scope_gl_apply(SCOPE_GL_STATE_CLEAR_COLOR, c[0] != r || c[1] != g || c[2] != b || c[3] != a, glClearColor(r, g, b, a));
+    c[0] = r; c[1] = g; c[2] = b; c[3] = a;
+}
+
+static inline void _scope_gl_blend_func(GLenum src, GLenum dst, GLenum old[2]) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_BLEND_FUNC);
+    if (old) { old[0] = gl->blend_src; old[1] = gl->blend_dst; }
+    _scope_gl_apply(SCOPE_GL_STATE_BLEND_FUNC, gl->blend_src != src || gl->blend_dst != dst, glBlendFunc(src, dst));
+    gl->blend_src = src; gl->blend_dst = dst;
+}
+
+static inline GLenum _scope_gl_blend_equation(GLenum eq) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_BLEND_EQUATION);
+    GLenum old = gl->blend_equation;
+    _scope_gl_apply(SCOPE_GL_STATE_BLEND_EQUATION, old != eq, glBlendEquation(eq));
+    gl->blend_equation = eq;
+    return old;
+}
+
+static inline GLenum _scope_gl_cull_face(GLenum mode) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_CULL_FACE);
+    GLenum old = gl->cull_face;
+    _scope_gl_apply(SCOPE_GL_STATE_CULL_FACE, old != mode, glCullFace(mode));
+    gl->cull_face = mode;
+    return old;
+}
+
+static inline GLenum _scope_gl_front_face(GLenum orient) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_FRONT_FACE);
+    GLenum old = gl->front_face;
+    _scope_gl_apply(SCOPE_GL_STATE_FRONT_FACE, old != orient, glFrontFace(orient));
+    gl->front_face = orient;
+    return old;
+}
+
+static inline GLuint _scope_gl_bind_sampler(GLuint unit, GLuint sampler) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_SAMPLERS);
+    if (unit >= SCOPE_GL_MAX_TEXTURE_UNITS) { /* not tracked */
+        _scope_gl_flush(SCOPE_GL_STATE_SAMPLERS | SCOPE_GL_STATE_TEXTURES);
+        GLuint old = _scope_gl_query_unit(unit, GL_SAMPLER_BINDING);
+        _scope_gl_stat(queries, SCOPE_GL_STAT_SAMPLERS);
+        _scope_gl_apply_now(SCOPE_GL_STATE_SAMPLERS, old != sampler, glBindSampler(unit, sampler));
+        return old;
+    }
+    GLuint old = gl->samplers[unit];
+    _scope_gl_apply(SCOPE_GL_STATE_SAMPLERS, old != sampler, glBindSampler(unit, sampler));
+    gl->samplers[unit] = sampler;
+    return old;
+}
+
+static inline GLuint _scope_gl_active_texture(GLuint unit) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_TEXTURES);
+    GLuint old = gl->active_texture;
+    _scope_gl_apply(SCOPE_GL_STATE_TEXTURES, old != unit, glActiveTexture(GL_TEXTURE0 + unit));
+    gl->active_texture = unit;
+    return old;
+}
+
+/* NOTE: tracked as GL_TEXTURE_2D bindings, a 0 unbinds every target of its unit like glBindTextures does */
+static inline int _scope_gl_set_unit_texture(scope_gl_state_t* gl, GLuint unit, GLuint tex) {
+    int differs = 0;
+    if (tex == 0) { for (int t = 0; t < _SCOPE_GL_TEXTURE_TARGET_COUNT; t++) { differs |= gl->textures[unit][t] != 0; gl->textures[unit][t] = 0; } }
+    else          { differs = gl->textures[unit][_SCOPE_GL_TEX_GL_TEXTURE_2D] != tex; gl->textures[unit][_SCOPE_GL_TEX_GL_TEXTURE_2D] = tex; }
+    return differs;
+}
+
+/* ranges past the tracked units are issued right away, everything is flushed first so the shadow copies agree */
+static inline void _scope_gl_bind_textures(GLuint first, GLsizei count, const GLuint* ids, GLuint* old) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_TEXTURES);
+    int untracked = first + (GLuint) count > SCOPE_GL_MAX_TEXTURE_UNITS, differs = untracked;
+    if (untracked) { _scope_gl_flush(SCOPE_GL_STATE_TEXTURES); }
+    for (GLsizei i = 0; i < count; i++) {
+        GLuint unit = first + (GLuint) i, tex = ids ? ids[i] : 0;
+        if (unit >= SCOPE_GL_MAX_TEXTURE_UNITS) {
+            if (old) { old[i] = _scope_gl_query_unit(unit, GL_TEXTURE_BINDING_2D); _scope_gl_stat(queries, SCOPE_GL_STAT_TEXTURES); }
+            continue;
+        }
+        if (old) { old[i] = gl->textures[unit][_SCOPE_GL_TEX_GL_TEXTURE_2D]; }
+        differs |= _scope_gl_set_unit_texture(gl, unit, tex);
+#ifdef SCOPE_GL_LAZY_STATE
+        if (untracked) { _scope_gl_set_unit_texture(&_scope_gl_ctx->gl, unit, tex); }
+#endif
+    }
+    if (untracked) { _scope_gl_apply_now(SCOPE_GL_STATE_TEXTURES, differs, glBindTextures(first, count, ids)); }
+    else           { _scope_gl_apply(SCOPE_GL_STATE_TEXTURES, differs, glBindTextures(first, count, ids)); }
+}
+
+static inline void _scope_gl_bind_samplers(GLuint first, GLsizei count, const GLuint* ids, GLuint* old) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_SAMPLERS);
+    int untracked = first + (GLuint) count > SCOPE_GL_MAX_TEXTURE_UNITS, differs = untracked;
+    if (untracked) { _scope_gl_flush(SCOPE_GL_STATE_SAMPLERS | SCOPE_GL_STATE_TEXTURES); }
+    for (GLsizei i = 0; i < count; i++) {
+        GLuint unit = first + (GLuint) i, sampler = ids ? ids[i] : 0;
+        if (unit >= SCOPE_GL_MAX_TEXTURE_UNITS) {
+            if (old) { old[i] = _scope_gl_query_unit(unit, GL_SAMPLER_BINDING); _scope_gl_stat(queries, SCOPE_GL_STAT_SAMPLERS); }
+            continue;
+        }
+        if (old) { old[i] = gl->samplers[unit]; }
+        differs |= gl->samplers[unit] != sampler;
+        gl->samplers[unit] = sampler;
+#ifdef SCOPE_GL_LAZY_STATE
+        if (untracked) { _scope_gl_ctx->gl.samplers[unit] = sampler; }
+#endif
+    }
+    if (untracked) { _scope_gl_apply_now(SCOPE_GL_STATE_SAMPLERS, differs, glBindSamplers(first, count, ids)); }
+    else           { _scope_gl_apply(SCOPE_GL_STATE_SAMPLERS, differs, glBindSamplers(first, count, ids)); }
+}
+
+/* NOTE: only the SSBO bindings are tracked, and unlike glBindBufferBase the generic binding is left alone */
+static inline void _scope_gl_bind_buffers_base(GLenum target, GLuint first, GLsizei count, const GLuint* ids, GLuint* old) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_SSBO);
+    if (target != GL_SHADER_STORAGE_BUFFER) { /* not tracked, except that the uniform block ranges follow */
+        if (old) { _scope_gl_query_indexed(target, first, count, old); _scope_gl_stat(queries, SCOPE_GL_STAT_BUFFERS); }
+        _scope_gl_apply_now(SCOPE_GL_STATE_BUFFERS, 1, glBindBuffersBase(target, first, count, ids));
+        for (GLsizei i = 0; target == GL_UNIFORM_BUFFER && i < count; i++) {
+            GLuint b = first + (GLuint) i;
+            if (b >= SCOPE_GL_MAX_BUFFER_BINDINGS) { break; }
+            GLint64* r = _scope_gl_known(SCOPE_GL_STATE_BUFFERS)->uniform_blocks[b];
+            r[0] = ids ? ids[i] : 0; r[1] = r[2] = 0;
+            memcpy(_scope_gl_ctx->gl.uniform_blocks[b], r, sizeof(_scope_gl_ctx->gl.uniform_blocks[b]));
+        }
+        return;
+    }
+    int untracked = first + (GLuint) count > SCOPE_GL_MAX_BUFFER_BINDINGS, differs = untracked;
+    if (untracked) { _scope_gl_flush(SCOPE_GL_STATE_SSBO); }
+    for (GLsizei i = 0; i < count; i++) {
+        GLuint b = first + (GLuint) i, buf = ids ? ids[i] : 0;
+        if (b >= SCOPE_GL_MAX_BUFFER_BINDINGS) {
+            if (old) { _scope_gl_query_indexed(target, b, 1, &old[i]); _scope_gl_stat(queries, SCOPE_GL_STAT_SSBO); }
+            continue;
+        }
+        if (old) { old[i] = gl->ssbo_bindings[b]; }
+        differs |= gl->ssbo_bindings[b] != buf;
+        gl->ssbo_bindings[b] = buf;
+#ifdef SCOPE_GL_LAZY_STATE
+        if (untracked) { _scope_gl_ctx->gl.ssbo_bindings[b] = buf; }
+#endif
+    }
+    if (untracked) { _scope_gl_apply_now(SCOPE_GL_STATE_SSBO, differs, glBindBuffersBase(target, first, count, ids)); }
+    else           { _scope_gl_apply(SCOPE_GL_STATE_SSBO, differs, glBindBuffersBase(target, first, count, ids)); }
+}
+
+#ifdef SCOPE_GL_DSA
+/* NOTE: binds to the texture's own target, so it has to match t. Not for texture 0, that would unbind all targets */
+static inline void _scope_gl_bind_texture_unit(GLuint unit, int t, GLuint texture) {
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_TEXTURES);
+    _scope_gl_apply(SCOPE_GL_STATE_TEXTURES, gl->textures[unit][t] != texture, glBindTextureUnit(unit, texture));
+    gl->textures[unit][t] = texture;
+}
+#endif
+
+/*
+** State blocks: a set of state that is built once and then applied with a single scope, e.g. per material:
+**
+**   scope_gl_state_block_t material = {0};
+**   scope_gl_block_glUseProgram(&material, shader);
+**   scope_gl_block_glBindVertexArray(&material, vao);
+**   scope_gl_block_glEnable(&material, GL_BLEND);
+**   scope_gl_block_glBlendFunc(&material, GL_ONE, GL_SRC_ALPHA);
+**   ...
+**   scope_glStateBlock(&material) { glDrawArrays(GL_TRIANGLES, 0, 6); }
+**
+** Only the fields set through the builders are part of the block (tracked by the masks), entering the scope compares
+** those against the tracked state and only changes what differs. Leaving the scope restores the overwritten values.
+*/
+typedef struct scope_gl_state_block_t {
+    GLuint           mask;                                                   /* SCOPE_GL_STATE_* groups that are set */
+    GLuint           caps_mask;                                              /* capabilities that are set */
+    GLuint           buffer_mask;                                            /* one bit per entry in _SCOPE_GL_BUFFER_TARGETS */
+    GLuint           ssbo_mask;                                              /* one bit per indexed binding */
+    GLuint           texture_mask[SCOPE_GL_MAX_TEXTURE_UNITS];               /* one bit per entry in _SCOPE_GL_TEXTURE_TARGETS */
+    scope_gl_state_t state;
+} scope_gl_state_block_t;
+
+scope_gl_state_block_t* _scope_gl_push_state_block(scope_gl_state_block_t* prev, scope_gl_state_block_t* block);
+void _scope_gl_apply_state_block(const scope_gl_state_block_t* block);
+
+/* builders, same arguments as the gl* call after the block. NOTE: untracked targets, units and bindings are ignored */
+static inline void scope_gl_block_glUseProgram(scope_gl_state_block_t* b, GLuint id)         { b->mask |= SCOPE_GL_STATE_PROGRAM;      b->state.program = id; }
+static inline void scope_gl_block_glBindVertexArray(scope_gl_state_block_t* b, GLuint vao)   { b->mask |= SCOPE_GL_STATE_VERTEX_ARRAY; b->state.vertex_array = vao; }
+static inline void scope_gl_block_glActiveTexture(scope_gl_state_block_t* b, GLenum texture) { b->state.active_texture = texture - GL_TEXTURE0; } /* unit for the following glBindTexture */
+static inline void scope_gl_block_glBindTexture(scope_gl_state_block_t* b, GLenum target, GLuint texture) {
+    int t = _scope_gl_texture_target_index(target);
+    GLuint unit = b->state.active_texture;
+    if (t < 0 || unit >= SCOPE_GL_MAX_TEXTURE_UNITS) { return; }
+    b->mask |= SCOPE_GL_STATE_TEXTURES; b->texture_mask[unit] |= 1u << t; b->state.textures[unit][t] = texture;
+}
+static inline void scope_gl_block_glBindBuffer(scope_gl_state_block_t* b, GLenum target, GLuint buffer) {
+    int t = _scope_gl_buffer_target_index(target);
+    if (t < 0) { return; }
+    b->mask |= SCOPE_GL_STATE_BUFFERS; b->buffer_mask |= 1u << t; b->state.buffers[t] = buffer;
+}
+static inline void scope_gl_block_glBindSSBO(scope_gl_state_block_t* b, GLuint ssbo, GLuint binding) {
+    if (binding >= SCOPE_GL_MAX_BUFFER_BINDINGS) { return; }
+    b->mask |= SCOPE_GL_STATE_SSBO; b->ssbo_mask |= 1u << binding; b->state.ssbo_bindings[binding] = ssbo;
+}
+static inline void scope_gl_block_glBindFramebuffer(scope_gl_state_block_t* b, GLenum target, GLuint fbo) { /* NOTE: the block always sets both */
+    b->mask |= SCOPE_GL_STATE_FRAMEBUFFER;
+    if (target != GL_READ_FRAMEBUFFER) { b->state.draw_framebuffer = fbo; }
+    if (target != GL_DRAW_FRAMEBUFFER) { b->state.read_framebuffer = fbo; }
+}
+static inline void scope_gl_block_glEnable(scope_gl_state_block_t* b, GLenum cap) {
+    int c = _scope_gl_cap_index(cap);
+    if (c < 0) { return; }
+    b->mask |= SCOPE_GL_STATE_CAPS; b->caps_mask |= 1u << c; b->state.caps |= 1u << c;
+}
+static inline void scope_gl_block_glDisable(scope_gl_state_block_t* b, GLenum cap) {
+    int c = _scope_gl_cap_index(cap);
+    if (c < 0) { return; }
+    b->mask |= SCOPE_GL_STATE_CAPS; b->caps_mask |= 1u << c; b->state.caps &= ~(1u << c);
+}
+static inline void scope_gl_block_glViewport(scope_gl_state_block_t* b, GLint x, GLint y, GLsizei w, GLsizei h) {
+    GLfloat* v = b->state.viewport[0];
+    b->mask |= SCOPE_GL_STATE_VIEWPORT; b->state.viewports = 1; v[0] = (GLfloat) x; v[1] = (GLfloat) y; v[2] = (GLfloat) w; v[3] = (GLfloat) h;
+}
+static inline void scope_gl_block_glScissor(scope_gl_state_block_t* b, GLint x, GLint y, GLsizei w, GLsizei h) {
+    GLint* s = b->state.scissor[0];
+    b->mask |= SCOPE_GL_STATE_SCISSOR; b->state.scissors = 1; s[0] = x; s[1] = y; s[2] = w; s[3] = h;
+}
+static inline void scope_gl_block_glClearColor(scope_gl_state_block_t* b, GLfloat r, GLfloat g, GLfloat bl, GLfloat a) {
+    b->mask |= SCOPE_GL_STATE_CLEAR_COLOR; b->state.clear_color[0] = r; b->state.clear_color[1] = g; b->state.clear_color[2] = bl; b->state.clear_color[3] = a;
+}
+static inline void scope_gl_block_glBlendFunc(scope_gl_state_block_t* b, GLenum src, GLenum dst) { b->mask |= SCOPE_GL_STATE_BLEND_FUNC;     b->state.blend_src = src; b->state.blend_dst = dst; }
+static inline void scope_gl_block_glBlendEquation(scope_gl_state_block_t* b, GLenum eq)          { b->mask |= SCOPE_GL_STATE_BLEND_EQUATION; b->state.blend_equation = eq; }
+static inline void scope_gl_block_glCullFace(scope_gl_state_block_t* b, GLenum mode)             { b->mask |= SCOPE_GL_STATE_CULL_FACE;      b->state.cull_face = mode; }
+static inline void scope_gl_block_glFrontFace(scope_gl_state_block_t* b, GLenum orient)          { b->mask |= SCOPE_GL_STATE_FRONT_FACE;     b->state.front_face = orient; }
+#else // SCOPE_GL_SHADOW_STATE
+#define _scope_gl_flush(mask) ((void) 0)
+#define _scope_gl_invalidate(mask) ((void) 0)
+#define _scope_gl_resync(mask) ((void) 0)
+#define _scope_gl_draw(record, call) (call)
+#endif // SCOPE_GL_SHADOW_STATE
+
+/* NOTE: GL_COPY_WRITE_BUFFER without DSA, so the vertex array and GL_ARRAY_BUFFER bindings are left alone (also for mapping) */
+static inline void _scope_gl_buffer_data(GLuint buffer, GLsizeiptr size, const void* data, GLenum usage) {
+#ifdef SCOPE_GL_DSA
+    glNamedBufferData(buffer, size, data, usage);
+#else
+    _scope_glBindBuffer(GL_COPY_WRITE_BUFFER, buffer) {
+        _scope_gl_flush(SCOPE_GL_STATE_BUFFERS);
+        glBufferData(GL_COPY_WRITE_BUFFER, size, data, usage);
+    }
+#endif
+}
+
+static inline void* _scope_gl_map_buffer(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    void* ptr = NULL;
+#ifdef SCOPE_GL_DSA
+    ptr = glMapNamedBufferRange(buffer, offset, length, access);
+#else
+    _scope_glBindBuffer(GL_COPY_WRITE_BUFFER, buffer) {
+        _scope_gl_flush(SCOPE_GL_STATE_BUFFERS);
+        ptr = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, length, access);
+    }
+#endif
+    return ptr;
+}
+static inline void _scope_gl_unmap_buffer(GLuint buffer) {
+#ifdef SCOPE_GL_DSA
+    glUnmapNamedBuffer(buffer);
+#else
+    _scope_glBindBuffer(GL_COPY_WRITE_BUFFER, buffer) {
+        _scope_gl_flush(SCOPE_GL_STATE_BUFFERS);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    }
+#endif
+}
+#define _scope_glMapBufferRange(buffer,offset,length,access,ptr) \
+    for (void* ptr = _scope_gl_map_buffer(buffer, offset, length, access), *UQ(map) = NULL; (UQ(map) == NULL); (UQ(map) = (void*) &UQ(map), ptr ? _scope_gl_unmap_buffer(buffer) : (void) 0))
+
+#include <string.h>
+
+/* NOTE: glBindBufferRange also binds the generic GL_UNIFORM_BUFFER, the shadow copy has to follow. Applied right
+ * away in lazy mode as well, so the tracked and the applied ranges never differ */
+static inline void _scope_gl_bind_uniform_range(GLuint binding, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+#ifdef SCOPE_GL_SHADOW_STATE
+    scope_gl_state_t* gl = _scope_gl_known(SCOPE_GL_STATE_BUFFERS);
+    _scope_gl_flush(SCOPE_GL_STATE_BUFFERS);
+    if (binding < SCOPE_GL_MAX_BUFFER_BINDINGS) {
+        GLint64* r = gl->uniform_blocks[binding];
+        if (r[0] == buffer && r[1] == offset && r[2] == size && gl->buffers[_SCOPE_GL_BUF_GL_UNIFORM_BUFFER] == buffer) {
+            _scope_gl_stat(skipped, SCOPE_GL_STAT_UNIFORMS);
+            return;
+        }
+        r[0] = buffer; r[1] = offset; r[2] = size;
+        memcpy(_scope_gl_ctx->gl.uniform_blocks[binding], r, sizeof(gl->uniform_blocks[binding]));
+    }
+    _scope_gl_ctx->gl.buffers[_SCOPE_GL_BUF_GL_UNIFORM_BUFFER] = buffer;
+    gl->buffers[_SCOPE_GL_BUF_GL_UNIFORM_BUFFER] = buffer;
+#endif
+    _scope_gl_stat(sets, SCOPE_GL_STAT_UNIFORMS);
+    if (size > 0) { glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size); }
+    else          { glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer); }
+}
+
+/* old = {buffer, offset, size} of the previous range, size -1 if nothing was bound */
+static inline void _scope_gl_uniform_block_push(GLuint binding, const void* data, GLsizeiptr size, GLint64 old[3]) {
+    void* dst;
+    GLintptr offset = scope_gl_ring_alloc(_scope_gl_ring, size, &dst);
+    old[0] = old[1] = 0; old[2] = -1;
+    if (offset < 0) { return; }
+#ifdef SCOPE_GL_RESTORE_STATE
+#ifdef SCOPE_GL_SHADOW_STATE
+    if (binding < SCOPE_GL_MAX_BUFFER_BINDINGS) {
+        memcpy(old, _scope_gl_known(SCOPE_GL_STATE_BUFFERS)->uniform_blocks[binding], 3 * sizeof(GLint64));
+    } else
+#endif
+    {
+        glGetInteger64i_v(GL_UNIFORM_BUFFER_BINDING, binding, &old[0]);
+        glGetInteger64i_v(GL_UNIFORM_BUFFER_START,   binding, &old[1]);
+        glGetInteger64i_v(GL_UNIFORM_BUFFER_SIZE,    binding, &old[2]);
+        _scope_gl_stat(queries, SCOPE_GL_STAT_UNIFORMS);
+    }
+#else
+    old[2] = 0;
+#endif
+    memcpy(dst, data, (size_t) size);
+    _scope_gl_bind_uniform_range(binding, _scope_gl_ring->buffer, offset, size);
+}
+static inline void _scope_gl_uniform_block_pop(GLuint binding, const GLint64 old[3]) {
+    if (old[2] >= 0) { _scope_gl_bind_uniform_range(binding, (GLuint) old[0], (GLintptr) old[1], (GLsizeiptr) old[2]); }
+}
+#define _ring_glUniformBlock(binding,ptr,size) \
+    for (GLint64 UQ(old_ubo)[3], UQ(i) = (_scope_gl_uniform_block_push(binding, ptr, size, UQ(old_ubo)), 0); (UQ(i) == 0); (UQ(i) += 1, _scope_gl_uniform_block_pop(binding, UQ(old_ubo))))
+
+/* what a scope_glBindlessTextures replaced, either the uniform block range or the texture units */
+typedef struct _scope_gl_bindless_scope_t {
+    int     bindless;
+    GLsizei count;                                                           /* clamped to the arrays */
+    GLint64 ubo[3];
+    GLuint  textures[SCOPE_GL_MAX_MULTI_BIND];
+} _scope_gl_bindless_scope_t;
+
+static inline void _scope_gl_bindless_push(_scope_gl_bindless_scope_t* old, GLuint binding, GLuint first, GLsizei count, const GLuint* textures) {
+    GLuint64 handles[SCOPE_GL_MAX_MULTI_BIND + 1] = {0};
+    old->count    = count = _scope_gl_multi_count(count);
+    old->bindless = _scope_gl_texture_handles(count, textures, handles);
+    if (old->bindless) { _scope_gl_uniform_block_push(binding, handles, (GLsizeiptr) ((count + 1) / 2) * 16, old->ubo); return; }
+#ifdef SCOPE_GL_SHADOW_STATE
+    _scope_gl_bind_textures(first, count, textures, old->textures);
+#else
+#ifdef SCOPE_GL_RESTORE_STATE
+    _scope_gl_query_units(first, count, GL_TEXTURE_BINDING_2D, old->textures);
+    _scope_gl_stat(queries, SCOPE_GL_STAT_TEXTURES);
+#endif
+    glBindTextures(first, count, textures);
+    _scope_gl_stat(sets, SCOPE_GL_STAT_TEXTURES);
+#endif
+}
+static inline void _scope_gl_bindless_pop(const _scope_gl_bindless_scope_t* old, GLuint binding, GLuint first) {
+    GLsizei count = old->count;
+    if (old->bindless) { _scope_gl_uniform_block_pop(binding, old->ubo); return; }
+#ifdef SCOPE_GL_SHADOW_STATE
+    _scope_gl_bind_textures(first, count, _scope_gl_popval(old->textures, (const GLuint*) NULL), NULL);
+#else
+    glBindTextures(first, count, _scope_gl_popval(old->textures, (const GLuint*) NULL));
+    _scope_gl_stat(sets, SCOPE_GL_STAT_TEXTURES);
+#endif
+}
+#define _ring_glBindlessTextures(binding,first,count,textures) \
+    for (_scope_gl_bindless_scope_t UQ(old_bl), *UQ(i) = (_scope_gl_bindless_push(&UQ(old_bl), binding, first, count, textures), &UQ(old_bl)); \
+         UQ(i); (UQ(i) = NULL, _scope_gl_bindless_pop(&UQ(old_bl), binding, first)))
+
+#endif // SCOPE_GL_H_
+
+#if defined(SCOPE_GL_IMPLEMENTATION) && !defined(SCOPE_GL_IMPLEMENTATION_H_)
+#define SCOPE_GL_IMPLEMENTATION_H_
+#include <string.h>
+#include <stdarg.h>
+
+#ifdef SCOPE_GL_STATS
+SCOPE_GL_THREAD_LOCAL scope_gl_stats_t _scope_gl_stats;
+#endif
+
+#ifdef SCOPE_GL_CHECK_ERRORS
+#include <stdio.h>
+
+SCOPE_GL_THREAD_LOCAL scope_gl_error_scopes_t _scope_gl_error_scopes;
+static scope_gl_error_handler_t _scope_gl_error_handler;
+static void*                    _scope_gl_error_user;
+
+void scope_gl_set_error_handler(scope_gl_error_handler_t handler, void* user) {
+    _scope_gl_error_handler = handler;
+    _scope_gl_error_user    = user;
+}
+
+static void _scope_gl_report_error(GLenum error, const char* message, const scope_gl_site_t* site) {
+    if (_scope_gl_error_handler) { _scope_gl_error_handler(error, message, site, _scope_gl_error_user); return; }
+    if (site) { fprintf(stderr, "%s:%d: %s scope: %s (0x%x)\n", site->file, site->line, scope_gl_stat_names[site->kind], message, error); }
+    else      { fprintf(stderr, "scope_gl: %s (0x%x)\n", message, error); }
+}
+
+static const char* _scope_gl_error_name(GLenum error) {
+    switch (error) {
+        case GL_INVALID_ENUM:                  return "GL_INVALID_ENUM";
+        case GL_INVALID_VALUE:                 return "GL_INVALID_VALUE";
+        case GL_INVALID_OPERATION:             return "GL_INVALID_OPERATION";
+        case GL_INVALID_FRAMEBUFFER_OPERATION: return "GL_INVALID_FRAMEBUFFER_OPERATION";
+        case GL_OUT_OF_MEMORY:                 return "GL_OUT_OF_MEMORY";
+        default:                               return "GL error";
+    }
+}
+
+GLuint scope_gl_errors_frame(void) {
+    scope_gl_error_scopes_t* e = &_scope_gl_error_scopes;
+    GLuint reported = 0;
+    for (GLenum err; (err = glGetError()) != GL_NO_ERROR && reported < 16; reported++) { /* NOTE: bounded, a lost context may never stop */
+        _scope_gl_report_error(err, _scope_gl_error_name(err), scope_gl_error_site());
+    }
+    /* called outside of all scopes, so anything still entered was left without its pop */
+    for (; e->depth > 0; e->depth--, reported++) {
+        _scope_gl_report_error(GL_NO_ERROR, "scope was never left, its state leaked", &e->ring[(e->depth - 1) & (SCOPE_GL_ERROR_RING - 1)]);
+    }
+#ifdef SCOPE_GL_STATS
+    _scope_gl_stats.depth = 0;
+#endif
+    return reported;
+}
+
+void _scope_gl_usage_error(const char* message) {
+    _scope_gl_report_error(GL_INVALID_VALUE, message, scope_gl_error_site());
+}
+
+void GLAPIENTRY scope_gl_debug_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                                        const GLchar* message, const void* user) {
+    (void) source; (void) id; (void) severity; (void) length; (void) user;
+    if (type == GL_DEBUG_TYPE_ERROR) { _scope_gl_report_error(id, message, scope_gl_error_site()); }
+}
+#endif
+
+#ifdef SCOPE_GL_CAPTURE
+#ifndef SCOPE_GL_CAPTURE_NOW
+#include <time.h>
+static uint64_t _scope_gl_capture_now(void) {
+    struct timespec t;
+#ifdef _WIN32
+    timespec_get(&t, TIME_UTC);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &t);
+#endif
+    return (uint64_t) t.tv_sec * 1000000000u + (uint64_t) t.tv_nsec;
+}
+#define SCOPE_GL_CAPTURE_NOW() _scope_gl_capture_now() /* nanoseconds */
+#endif
+
+SCOPE_GL_THREAD_LOCAL scope_gl_capture_t* _scope_gl_capture;
+
+/* hands the current chunk to the drain if there is a free one to continue in, or at the end */
+static int _scope_gl_capture_hand_over(scope_gl_capture_t* capture, int last) {
+    GLuint next = (capture->chunk + 1) % SCOPE_GL_CAPTURE_CHUNKS;
+    if (capture->head == 0) { return 1; }
+    if (!last && _scope_gl_capture_load(&capture->used[next]) != 0) { return 0; }
+    _scope_gl_capture_store(&capture->used[capture->chunk], (uint32_t) capture->head);
+    capture->chunk = next;
+    capture->head  = 0;
+    return 1;
+}
+
+static uint32_t* _scope_gl_capture_alloc(scope_gl_capture_t* capture, size_t words) {
+    if (capture->head + words > capture->chunk_words && (words > capture->chunk_words || !_scope_gl_capture_hand_over(capture, 0))) {
+        capture->dropped++;
+        return NULL;
+    }
+    uint32_t* p = capture->memory + capture->chunk * capture->chunk_words + capture->head;
+    capture->head += words;
+    return p;
+}
+
+void scope_gl_capture_init(scope_gl_capture_t* capture, void* memory, size_t size, GLuint frames) {
+    memset((void*) capture, 0, sizeof(*capture)); /* NOTE: all zero bytes are 0 for the atomics as well */
+    capture->memory      = (uint32_t*) memory;
+    capture->chunk_words = size / sizeof(uint32_t) / SCOPE_GL_CAPTURE_CHUNKS;
+    capture->frames      = frames;
+    capture->time        = SCOPE_GL_CAPTURE_NOW();
+    capture->active      = 1;
+    uint32_t* header = _scope_gl_capture_alloc(capture, 2);
+    if (header) { memcpy(&header[0], "SGLT", 4); header[1] = 1; }
+}
+
+/* site ids are handed out by the first event from a __FILE__/__LINE__ pair, which is preceded by its name */
+static GLuint _scope_gl_capture_site(scope_gl_capture_t* capture, const char* file, int line) {
+    if (!file) { return 0; }
+    GLuint i = (GLuint) (((uintptr_t) file >> 3) ^ ((GLuint) line * 2654435761u));
+    for (GLuint n = 0; n < SCOPE_GL_CAPTURE_SITES; n++, i++) {
+        GLuint slot = i & (SCOPE_GL_CAPTURE_SITES - 1);
+        if (capture->site_files[slot] == file && capture->site_lines[slot] == line) { return slot + 1; }
+        if (capture->site_files[slot] != NULL) { continue; }
+
+        size_t length = strlen(file);
+        const char* name = (length > 255) ? file + length - 255 : file; /* NOTE: keeps the end of long paths */
+        if (length > 255) { length = 255; }
+        uint32_t* e = _scope_gl_capture_alloc(capture, 3 + (length + 3) / 4);
+        if (!e) { return 0; }
+        e[0] = SCOPE_GL_OP_SITE | (slot + 1) << 16;
+        e[1] = (uint32_t) line;
+        e[2] = (uint32_t) length;
+        if (length % 4) { e[3 + length / 4] = 0; }
+        memcpy(&e[3], name, length);
+        capture->site_files[slot] = file;
+        capture->site_lines[slot] = line;
+        return slot + 1;
+    }
+    return 0;
+}
+
+/* 1 if the event made it into the capture */
+int _scope_gl_capture_event(scope_gl_capture_t* capture, int op, const char* file, int line, const GLuint* args) {
+    if (capture->skipping && op != SCOPE_GL_OP_FRAME) { capture->dropped++; return 0; }
+    GLuint site = _scope_gl_capture_site(capture, file, line);
+    uint32_t* e = _scope_gl_capture_alloc(capture, 2 + scope_gl_op_args[op]);
+    capture->skipping = (e == NULL);
+    if (!e) { return 0; }
+    uint64_t now  = SCOPE_GL_CAPTURE_NOW();
+    uint64_t dt   = now - capture->time;
+    capture->time = now;
+    e[0] = (uint32_t) op | site << 16;
+    e[1] = dt > 0xffffffffu ? 0xffffffffu : (uint32_t) dt;
+    for (int i = 0; i < scope_gl_op_args[op]; i++) { e[2 + i] = args[i]; }
+    capture->events++;
+    return 1;
+}
+
+void scope_gl_capture_frame(scope_gl_capture_t* capture) {
+    if (!capture->active) { return; }
+    _scope_gl_capture_event(capture, SCOPE_GL_OP_FRAME, NULL, 0, NULL);
+    if (capture->frames > 0 && --capture->frames == 0) { scope_gl_capture_stop(capture); return; }
+    _scope_gl_capture_hand_over(capture, 0); /* NOTE: the drain gets every frame early, unless it is behind */
+}
+
+void scope_gl_capture_stop(scope_gl_capture_t* capture) {
+    if (!capture->active) { return; }
+    capture->active = 0;
+    _scope_gl_capture_hand_over(capture, 1);
+    _scope_gl_capture_store(&capture->done, 1);
+}
+
+int scope_gl_capture_drain(scope_gl_capture_t* capture, FILE* file) {
+    int done = (int) _scope_gl_capture_load(&capture->done); /* NOTE: before the chunks, so the last one is not missed */
+    for (uint32_t words; (words = _scope_gl_capture_load(&capture->used[capture->drained])) != 0; ) {
+        fwrite(capture->memory + capture->drained * capture->chunk_words, sizeof(uint32_t), words, file);
+        _scope_gl_capture_store(&capture->used[capture->drained], 0);
+        capture->drained = (capture->drained + 1) % SCOPE_GL_CAPTURE_CHUNKS;
+    }
+    if (done) { fflush(file); }
+    return !done;
+}
+#endif
+
+SCOPE_GL_THREAD_LOCAL scope_gl_timers_t* _scope_gl_timers;
+
+void scope_gl_timers_init(scope_gl_timers_t* timers) {
+    memset(timers, 0, sizeof(*timers));
+    timers->open = -1;
+    for (int f = 0; f < SCOPE_GL_TIMER_FRAMES; f++) { glGenQueries(2 * SCOPE_GL_MAX_TIMERS, timers->frames[f].queries); }
+}
+
+void scope_gl_timers_destroy(scope_gl_timers_t* timers) {
+    for (int f = 0; f < SCOPE_GL_TIMER_FRAMES; f++) { glDeleteQueries(2 * SCOPE_GL_MAX_TIMERS, timers->frames[f].queries); }
+    if (_scope_gl_timers == timers) { _scope_gl_timers = NULL; }
+}
+
+GLint _scope_gl_timer_begin(const char* name) {
+    scope_gl_timers_t* t = _scope_gl_timers;
+    if (!t) { return -1; }
+    scope_gl_timer_frame_t* f = &t->frames[t->frame];
+    if (f->count >= SCOPE_GL_MAX_TIMERS) { return -1; }
+
+    GLint i = (GLint) f->count++;
+    f->names[i]   = name;
+    f->parents[i] = t->open;
+    f->depths[i]  = (t->open < 0) ? 0 : f->depths[t->open] + 1;
+    f->last       = 2 * i;
+    t->open       = i;
+    glQueryCounter(f->queries[2 * i], GL_TIMESTAMP);
+    return i;
+}
+
+void _scope_gl_timer_end(GLint timer) {
+    scope_gl_timers_t* t = _scope_gl_timers;
+    if (timer < 0 || !t) { return; }
+    scope_gl_timer_frame_t* f = &t->frames[t->frame];
+    f->last = 2 * timer + 1;
+    t->open = f->parents[timer];
+    glQueryCounter(f->queries[2 * timer + 1], GL_TIMESTAMP);
+}
+
+/* timestamps complete in order, so once the last query of the oldest frame is available all of them are */
+void scope_gl_timers_frame(scope_gl_timers_t* timers) {
+    timers->frame = (timers->frame + 1) % SCOPE_GL_TIMER_FRAMES;
+    timers->open  = -1;
+    scope_gl_timer_frame_t* f = &timers->frames[timers->frame];
+    timers->result_count = 0; /* NOTE: no stale results of an earlier frame */
+    if (f->count > 0) {
+        GLuint available = 0;
+        glGetQueryObjectuiv(f->queries[f->last], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            for (GLuint i = 0; i < f->count; i++) {
+                GLuint64 begin = 0, end = 0;
+                glGetQueryObjectui64v(f->queries[2 * i],     GL_QUERY_RESULT, &begin);
+                glGetQueryObjectui64v(f->queries[2 * i + 1], GL_QUERY_RESULT, &end);
+                timers->results[i].name   = f->names[i];
+                timers->results[i].depth  = f->depths[i];
+                timers->results[i].parent = f->parents[i];
+                timers->results[i].ns     = end - begin;
+            }
+            timers->result_count = f->count;
+        } else {
+            timers->missed++;
+        }
+    }
+    f->count = 0;
+}
+
+SCOPE_GL_THREAD_LOCAL scope_gl_samplers_t* _scope_gl_samplers;
+
+void scope_gl_samplers_init(scope_gl_samplers_t* samplers) { memset(samplers, 0, sizeof(*samplers)); }
+
+void scope_gl_samplers_destroy(scope_gl_samplers_t* samplers) {
+    for (GLuint i = 0; i < SCOPE_GL_MAX_SAMPLERS; i++) {
+        if (samplers->entries[i].sampler) { glDeleteSamplers(1, &samplers->entries[i].sampler); }
+    }
+    memset(samplers, 0, sizeof(*samplers));
+    if (_scope_gl_samplers == samplers) { _scope_gl_samplers = NULL; }
+}
+
+GLuint scope_gl_sampler_get(const GLint* params, GLsizei count) {
+    scope_gl_samplers_t* c = _scope_gl_samplers;
+    if (!c) { return 0; }
+    if (count > 2 * SCOPE_GL_MAX_SAMPLER_PARAMS) { c->rejected++; return 0; }
+
+    GLuint hash = 2166136261u; /* FNV-1a */
+    for (GLsizei i = 0; i < count; i++) { hash = (hash ^ (GLuint) params[i]) * 16777619u; }
+
+    for (GLuint n = 0, i = hash; n < SCOPE_GL_MAX_SAMPLERS; n++, i++) {
+        scope_gl_sampler_entry_t* e = &c->entries[i & (SCOPE_GL_MAX_SAMPLERS - 1)];
+        if (e->sampler == 0) {
+            if (c->count >= SCOPE_GL_MAX_SAMPLERS - 1) { break; } /* NOTE: one slot stays free to end the probing */
+            glGenSamplers(1, &e->sampler);
+            for (GLsizei p = 0; p + 1 < count; p += 2) { glSamplerParameteri(e->sampler, (GLenum) params[p], params[p + 1]); }
+            e->hash  = hash;
+            e->count = count;
+            memcpy(e->params, params, (size_t) count * sizeof(GLint));
+            c->count++;
+            return e->sampler;
+        }
+        if (e->hash == hash && e->count == count && memcmp(e->params, params, (size_t) count * sizeof(GLint)) == 0) { return e->sampler; }
+    }
+    c->rejected++;
+    return 0;
+}
+
+GLuint _scope_gl_sampler_getv(GLsizei count, ...) {
+    GLint params[2 * SCOPE_GL_MAX_SAMPLER_PARAMS];
+    if (count > 2 * SCOPE_GL_MAX_SAMPLER_PARAMS) { return scope_gl_sampler_get(NULL, count); }
+    va_list args;
+    va_start(args, count);
+    for (GLsizei i = 0; i < count; i++) { params[i] = va_arg(args, GLint); }
+    va_end(args);
+    return scope_gl_sampler_get(params, count);
+}
+
+SCOPE_GL_THREAD_LOCAL scope_gl_framebuffers_t* _scope_gl_framebuffers;
+static scope_gl_framebuffer_entry_t _scope_gl_no_framebuffer; /* framebuffer 0 with an empty viewport, never written */
+
+void scope_gl_framebuffers_init(scope_gl_framebuffers_t* framebuffers) { memset(framebuffers, 0, sizeof(*framebuffers)); }
+
+void scope_gl_framebuffers_destroy(scope_gl_framebuffers_t* framebuffers) {
+    for (GLuint i = 0; i < SCOPE_GL_MAX_FRAMEBUFFERS; i++) {
+        if (framebuffers->entries[i].fbo) { glDeleteFramebuffers(1, &framebuffers->entries[i].fbo); }
+    }
+    memset(framebuffers, 0, sizeof(*framebuffers));
+    if (_scope_gl_framebuffers == framebuffers) { _scope_gl_framebuffers = NULL; }
+}
+
+void scope_gl_framebuffers_forget(scope_gl_framebuffers_t* framebuffers, GLuint object) {
+    scope_gl_framebuffer_entry_t kept[SCOPE_GL_MAX_FRAMEBUFFERS];
+    GLuint count = 0;
+    for (GLuint i = 0; i < SCOPE_GL_MAX_FRAMEBUFFERS; i++) {
+        scope_gl_framebuffer_entry_t* e = &framebuffers->entries[i];
+        if (e->fbo == 0) { continue; }
+        int uses = (object == 0);
+        for (GLsizei j = 1; j < e->count; j += 2) { uses |= (e->attachments[j] == object); }
+        if (uses) { glDeleteFramebuffers(1, &e->fbo); }
+        else      { kept[count++] = *e; }
+    }
+    /* NOTE: the others are inserted again, a freed slot would end the probing for the sets behind it */
+    memset(framebuffers->entries, 0, sizeof(framebuffers->entries));
+    framebuffers->count = count;
+    for (GLuint k = 0; k < count; k++) {
+        GLuint i = kept[k].hash;
+        while (framebuffers->entries[i & (SCOPE_GL_MAX_FRAMEBUFFERS - 1)].fbo) { i++; }
+        framebuffers->entries[i & (SCOPE_GL_MAX_FRAMEBUFFERS - 1)] = kept[k];
+    }
+}
+
+static void _scope_gl_attachment_size(GLuint object, GLint* width, GLint* height) {
+    GLuint name = object & ~SCOPE_GL_RENDERBUFFER(0);
+#ifdef SCOPE_GL_DSA
+    if (object & SCOPE_GL_RENDERBUFFER(0)) {
+        glGetNamedRenderbufferParameteriv(name, GL_RENDERBUFFER_WIDTH,  width);
+        glGetNamedRenderbufferParameteriv(name, GL_RENDERBUFFER_HEIGHT, height);
+    } else {
+        glGetTextureLevelParameteriv(name, 0, GL_TEXTURE_WIDTH,  width);
+        glGetTextureLevelParameteriv(name, 0, GL_TEXTURE_HEIGHT, height);
+    }
+#else
+    if (object & SCOPE_GL_RENDERBUFFER(0)) {
+        _scope_glBindRenderbuffer(GL_RENDERBUFFER, name) {
+            _scope_gl_flush(SCOPE_GL_STATE_RENDERBUFFER);
+            glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_WIDTH,  width);
+            glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_HEIGHT, height);
+        }
+    } else {
+        _scope_glBindTexture(GL_TEXTURE_2D, name) {
+            _scope_gl_flush(SCOPE_GL_STATE_TEXTURES);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH,  width);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, height);
+        }
+    }
+#endif
+}
+
+static void _scope_gl_framebuffer_create(scope_gl_framebuffer_entry_t* e) {
+    GLenum  draw_buffers[SCOPE_GL_MAX_ATTACHMENTS];
+    GLsizei draw_count = 0;
+    GLint   width = 0x7fffffff, height = 0x7fffffff;
+    for (GLsizei i = 0; i + 1 < e->count; i += 2) {
+        GLint w = 0, h = 0;
+        _scope_gl_attachment_size(e->attachments[i + 1], &w, &h);
+        if (w < width)  { width  = w; }
+        if (h < height) { height = h; }
+        if (e->attachments[i] >= GL_COLOR_ATTACHMENT0 && e->attachments[i] <= GL_COLOR_ATTACHMENT31) { draw_buffers[draw_count++] = e->attachments[i]; }
+    }
+
+    GLenum status = 0;
+#ifdef SCOPE_GL_DSA
+    glCreateFramebuffers(1, &e->fbo);
+    for (GLsizei i = 0; i + 1 < e->count; i += 2) {
+        GLuint name = e->attachments[i + 1] & ~SCOPE_GL_RENDERBUFFER(0);
+        if (e->attachments[i + 1] & SCOPE_GL_RENDERBUFFER(0)) { glNamedFramebufferRenderbuffer(e->fbo, e->attachments[i], GL_RENDERBUFFER, name); }
+        else                                                  { glNamedFramebufferTexture(e->fbo, e->attachments[i], name, 0); }
+    }
+    glNamedFramebufferDrawBuffers(e->fbo, draw_count, draw_buffers);
+    status = glCheckNamedFramebufferStatus(e->fbo, GL_FRAMEBUFFER);
+#else
+    glGenFramebuffers(1, &e->fbo);
+    _scope_glBindFBO(e->fbo) {
+        _scope_gl_flush(SCOPE_GL_STATE_FRAMEBUFFER);
+        for (GLsizei i = 0; i + 1 < e->count; i += 2) {
+            GLuint name = e->attachments[i + 1] & ~SCOPE_GL_RENDERBUFFER(0);
+            if (e->attachments[i + 1] & SCOPE_GL_RENDERBUFFER(0)) { glFramebufferRenderbuffer(GL_FRAMEBUFFER, e->attachments[i], GL_RENDERBUFFER, name); }
+            else                                                  { glFramebufferTexture(GL_FRAMEBUFFER, e->attachments[i], name, 0); }
+        }
+        glDrawBuffers(draw_count, draw_buffers);
+        status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    }
+#endif
+    /* NOTE: an incomplete set keeps its slot, so it is not created again on every use */
+    int complete = (status == GL_FRAMEBUFFER_COMPLETE) && e->count > 0;
+    e->width  = complete ? width  : 0;
+    e->height = complete ? height : 0;
+}
+
+static const scope_gl_framebuffer_entry_t* _scope_gl_framebuffer_reject(scope_gl_framebuffers_t* c, const char* message) {
+    if (c) { c->rejected++; }
+    (void) _scope_gl_check(0, message);
+    (void) message;
+    return &_scope_gl_no_framebuffer;
+}
+
+const scope_gl_framebuffer_entry_t* scope_gl_framebuffer_get(const GLuint* attachments, GLsizei count) {
+    scope_gl_framebuffers_t* c = _scope_gl_framebuffers;
+    if (!c) { return _scope_gl_framebuffer_reject(c, "scope_glRenderTarget: no current framebuffer cache"); }
+    if (count > 2 * SCOPE_GL_MAX_ATTACHMENTS) { return _scope_gl_framebuffer_reject(c, "scope_glRenderTarget: more than SCOPE_GL_MAX_ATTACHMENTS attachments"); }
+
+    GLuint hash = 2166136261u; /* FNV-1a */
+    for (GLsizei i = 0; i < count; i++) { hash = (hash ^ attachments[i]) * 16777619u; }
+
+    for (GLuint n = 0, i = hash; n < SCOPE_GL_MAX_FRAMEBUFFERS; n++, i++) {
+        scope_gl_framebuffer_entry_t* e = &c->entries[i & (SCOPE_GL_MAX_FRAMEBUFFERS - 1)];
+        if (e->fbo == 0) {
+            if (c->count >= SCOPE_GL_MAX_FRAMEBUFFERS - 1) { break; } /* NOTE: one slot stays free to end the probing */
+            e->hash  = hash;
+            e->count = count;
+            memcpy(e->attachments, attachments, (size_t) count * sizeof(GLuint));
+            _scope_gl_framebuffer_create(e);
+            c->count++;
+        } else if (e->hash != hash || e->count != count || memcmp(e->attachments, attachments, (size_t) count * sizeof(GLuint)) != 0) {
+            continue;
+        }
+        if (e->width == 0) { return _scope_gl_framebuffer_reject(c, "scope_glRenderTarget: incomplete attachment set"); }
+        return e;
+    }
+    return _scope_gl_framebuffer_reject(c, "scope_glRenderTarget: framebuffer cache full (SCOPE_GL_MAX_FRAMEBUFFERS)");
+}
+
+const scope_gl_framebuffer_entry_t* _scope_gl_framebuffer_getv(GLsizei count, ...) {
+    GLuint attachments[2 * SCOPE_GL_MAX_ATTACHMENTS];
+    if (count > 2 * SCOPE_GL_MAX_ATTACHMENTS) { return scope_gl_framebuffer_get(NULL, count); }
+    va_list args;
+    va_start(args, count);
+    for (GLsizei i = 0; i < count; i++) { attachments[i] = va_arg(args, GLuint); }
+    va_end(args);
+    return scope_gl_framebuffer_get(attachments, count);
+}
+
+SCOPE_GL_THREAD_LOCAL scope_gl_residency_t* _scope_gl_residency;
+
+int scope_gl_residency_init(scope_gl_residency_t* residency, GLsizeiptr budget) {
+    memset(residency, 0, sizeof(*residency));
+    residency->budget = budget;
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count && !residency->bindless; i++) {
+        const char* name = (const char*) glGetStringi(GL_EXTENSIONS, (GLuint) i);
+        residency->bindless = name && strcmp(name, "GL_ARB_bindless_texture") == 0;
+    }
+    return residency->bindless;
+}
+
+void scope_gl_residency_destroy(scope_gl_residency_t* residency) {
+    for (GLuint i = 0; i < SCOPE_GL_MAX_RESIDENT; i++) {
+        if (residency->entries[i].resident) { glMakeTextureHandleNonResidentARB(residency->entries[i].handle); }
+    }
+    memset(residency, 0, sizeof(*residency));
+    if (_scope_gl_residency == residency) { _scope_gl_residency = NULL; }
+}
+
+/* level 0 in bytes, a third more with mipmaps */
+static GLsizeiptr _scope_gl_texture_size(GLuint texture) {
+    GLint w = 0, h = 0, d = 0, compressed = 0, size = 0, mipmapped = 0, bits[6] = {0};
+    static const GLenum components[6] = { GL_TEXTURE_RED_SIZE, GL_TEXTURE_GREEN_SIZE, GL_TEXTURE_BLUE_SIZE,
+                                          GL_TEXTURE_ALPHA_SIZE, GL_TEXTURE_DEPTH_SIZE, GL_TEXTURE_STENCIL_SIZE };
+#ifdef SCOPE_GL_DSA
+    glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_WIDTH,  &w);
+    glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_HEIGHT, &h);
+    glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_DEPTH,  &d);
+    glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_COMPRESSED, &compressed);
+    if (compressed) { glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size); }
+    else            { for (int i = 0; i < 6; i++) { glGetTextureLevelParameteriv(texture, 0, components[i], &bits[i]); } }
+    glGetTextureLevelParameteriv(texture, 1, GL_TEXTURE_WIDTH, &mipmapped);
+#else
+    _scope_glBindTexture(GL_TEXTURE_2D, texture) {
+        _scope_gl_flush(SCOPE_GL_STATE_TEXTURES);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH,  &w);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &h);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_DEPTH,  &d);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+        if (compressed) { glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size); }
+        else            { for (int i = 0; i < 6; i++) { glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, components[i], &bits[i]); } }
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 1, GL_TEXTURE_WIDTH, &mipmapped);
+    }
+#endif
+    GLsizeiptr bytes = compressed ? size : (GLsizeiptr) w * h * (d > 0 ? d : 1) * ((bits[0] + bits[1] + bits[2] + bits[3] + bits[4] + bits[5] + 7) / 8);
+    return mipmapped ? bytes + bytes / 3 : bytes;
+}
+
+static scope_gl_resident_t* _scope_gl_resident_find(scope_gl_residency_t* r, GLuint texture, int create) {
+    for (GLuint n = 0, i = texture * 2654435761u; n < SCOPE_GL_MAX_RESIDENT; n++, i++) {
+        scope_gl_resident_t* e = &r->entries[i & (SCOPE_GL_MAX_RESIDENT - 1)];
+        if (e->texture == texture) { return e; }
+        if (e->texture != 0) { continue; }
+        if (!create) { return NULL; }
+        if (r->count >= SCOPE_GL_MAX_RESIDENT - 1) { break; } /* NOTE: one slot stays free to end the probing */
+        /* NOTE: a failed handle keeps its slot with handle 0, so it is not asked for again on every use */
+        e->texture = texture;
+        e->handle  = glGetTextureHandleARB(texture);
+        e->size    = e->handle ? _scope_gl_texture_size(texture) : 0;
+        r->count++;
+        return e;
+    }
+    r->rejected++;
+    return NULL;
+}
+
+GLuint64 scope_gl_texture_handle(GLuint texture) {
+    scope_gl_residency_t* r = _scope_gl_residency;
+    if (!r || !r->bindless || texture == 0) { return 0; }
+    scope_gl_resident_t* e = _scope_gl_resident_find(r, texture, 1);
+    if (!e || !e->handle) { return 0; }
+    if (!e->resident) {
+        glMakeTextureHandleResidentARB(e->handle);
+        e->resident = 1;
+        r->resident_size += e->size;
+    }
+    e->frame = r->frame;
+    return e->handle;
+}
+
+GLuint64 scope_gl_texture_acquire(GLuint texture) {
+    GLuint64 handle = scope_gl_texture_handle(texture);
+    if (handle) { _scope_gl_resident_find(_scope_gl_residency, texture, 0)->refs++; }
+    return handle;
+}
+
+void scope_gl_texture_release(GLuint texture) {
+    scope_gl_resident_t* e = _scope_gl_residency ? _scope_gl_resident_find(_scope_gl_residency, texture, 0) : NULL;
+    if (e && e->refs > 0) { e->refs--; }
+}
+
+void scope_gl_residency_frame(scope_gl_residency_t* residency) {
+    residency->frame++;
+    while (residency->resident_size > residency->budget) {
+        scope_gl_resident_t* lru = NULL;
+        for (GLuint i = 0; i < SCOPE_GL_MAX_RESIDENT; i++) {
+            scope_gl_resident_t* e = &residency->entries[i];
+            int in_flight = e->frame + SCOPE_GL_RING_FRAMES > residency->frame;
+            if (e->resident && e->refs == 0 && !in_flight && (!lru || e->frame < lru->frame)) { lru = e; }
+        }
+        if (!lru) { break; } /* NOTE: everything left is acquired or still in flight */
+        glMakeTextureHandleNonResidentARB(lru->handle);
+        lru->resident = 0;
+        residency->resident_size -= lru->size;
+        residency->evictions++;
+    }
+}
+
+/* all handles or none, a scope falls back to binding units if any texture has no handle */
+int _scope_gl_texture_handles(GLsizei count, const GLuint* textures, GLuint64* handles) {
+    if (!scope_gl_bindless_available() || count > SCOPE_GL_MAX_MULTI_BIND) { return 0; }
+    for (GLsizei i = 0; i < count; i++) {
+        handles[i] = scope_gl_texture_handle(textures[i]);
+        if (!handles[i] && textures[i]) { return 0; }
+    }
+    return 1;
+}
+
+SCOPE_GL_THREAD_LOCAL scope_gl_ring_t* _scope_gl_ring;
+
+int scope_gl_ring_init(scope_gl_ring_t* ring, GLenum target, GLsizeiptr segment_size) {
+    memset(ring, 0, sizeof(*ring));
+    GLint alignment = 16;
+    if (target == GL_UNIFORM_BUFFER)        { glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment); }
+    if (target == GL_SHADER_STORAGE_BUFFER) { glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment); }
+    ring->alignment    = (alignment > 0) ? alignment : 16;
+    ring->segment_size = (segment_size + ring->alignment - 1) / ring->alignment * ring->alignment;
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const GLsizeiptr size  = SCOPE_GL_RING_FRAMES * ring->segment_size;
+#ifdef SCOPE_GL_DSA
+    glCreateBuffers(1, &ring->buffer);
+    glNamedBufferStorage(ring->buffer, size, NULL, flags);
+    ring->memory = (unsigned char*) glMapNamedBufferRange(ring->buffer, 0, size, flags);
+#else
+    glGenBuffers(1, &ring->buffer);
+    _scope_glBindBuffer(GL_COPY_WRITE_BUFFER, ring->buffer) {
+        _scope_gl_flush(SCOPE_GL_STATE_BUFFERS);
+        glBufferStorage(GL_COPY_WRITE_BUFFER, size, NULL, flags);
+        ring->memory = (unsigned char*) glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags);
+    }
+#endif
+    return ring->memory != NULL;
+}
+
+void scope_gl_ring_destroy(scope_gl_ring_t* ring) {
+    for (int f = 0; f < SCOPE_GL_RING_FRAMES; f++) { if (ring->fences[f]) { glDeleteSync(ring->fences[f]); } }
+    glDeleteBuffers(1, &ring->buffer); /* NOTE: also unmaps it */
+    memset(ring, 0, sizeof(*ring));
+    if (_scope_gl_ring == ring) { _scope_gl_ring = NULL; }
+}
+
+/* the fence of the next segment was set SCOPE_GL_RING_FRAMES - 1 frames ago, usually it has long been signaled */
+void scope_gl_ring_frame(scope_gl_ring_t* ring) {
+    if (!ring->memory) { return; }
+    if (ring->fences[ring->segment]) { glDeleteSync(ring->fences[ring->segment]); }
+    ring->fences[ring->segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ring->segment = (ring->segment + 1) % SCOPE_GL_RING_FRAMES;
+    ring->head    = 0;
+    if (ring->pending[ring->segment]) { ring->head = ring->segment_size; return; } /* still staged, skip a frame */
+
+    GLsync fence = ring->fences[ring->segment];
+    if (!fence) { return; }
+    if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        ring->stalls++;
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+    }
+    glDeleteSync(fence);
+    ring->fences[ring->segment] = NULL;
+}
+
+GLintptr scope_gl_ring_alloc(scope_gl_ring_t* ring, GLsizeiptr size, void** ptr) {
+    *ptr = NULL;
+    if (!ring) { return -1; }
+    GLsizeiptr head = (ring->head + ring->alignment - 1) / ring->alignment * ring->alignment;
+    if (!ring->memory || head + size > ring->segment_size) { ring->overflows++; return -1; }
+    ring->head = head + size;
+    GLintptr offset = (GLintptr) ring->segment * ring->segment_size + head;
+    *ptr = ring->memory + offset;
+    return offset;
+}
+
+void* scope_gl_ring_stage(scope_gl_ring_t* ring, GLsizeiptr size, GLintptr* offset) {
+    void* ptr;
+    *offset = scope_gl_ring_alloc(ring, size, &ptr);
+    if (*offset >= 0) { ring->pending[ring->segment]++; }
+    return ptr;
+}
+
+/* the fence of a segment whose frame has already ended is put again behind its last upload */
+void scope_gl_ring_upload_2d(scope_gl_ring_t* ring, GLintptr offset, GLuint texture, GLint level, GLint x, GLint y, GLsizei w, GLsizei h, GLenum format, GLenum type) {
+    if (offset < 0) { return; }
+    scope_glPixelUnpackBuffer(ring->buffer) {
+#ifdef SCOPE_GL_DSA
+        _scope_gl_flush(SCOPE_GL_STATE_BUFFERS);
+        glTextureSubImage2D(texture, level, x, y, w, h, format, type, (const void*) offset);
+#else
+        scope_glBindTexture(GL_TEXTURE_2D, texture) {
+            _scope_gl_flush(SCOPE_GL_STATE_BUFFERS | SCOPE_GL_STATE_TEXTURES);
+            glTexSubImage2D(GL_TEXTURE_2D, level, x, y, w, h, format, type, (const void*) offset);
+        }
+#endif
+    }
+    GLuint s = (GLuint) (offset / ring->segment_size);
+    if (ring->pending[s] && --ring->pending[s] == 0 && s != ring->segment) {
+        if (ring->fences[s]) { glDeleteSync(ring->fences[s]); }
+        ring->fences[s] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
+
+int scope_gl_stream_init(scope_gl_stream_t* stream, int mode, GLsizeiptr size) {
+    memset(stream, 0, sizeof(*stream));
+    stream->mode = mode;
+    stream->size = size;
+    if (mode == SCOPE_GL_STREAM_PERSISTENT) {
+        int ok = scope_gl_ring_init(&stream->ring, GL_ARRAY_BUFFER, size);
+        stream->buffer = stream->ring.buffer;
+        return ok;
+    }
+#ifdef SCOPE_GL_DSA
+    glCreateBuffers(1, &stream->buffer);
+#else
+    glGenBuffers(1, &stream->buffer);
+#endif
+    _scope_gl_buffer_data(stream->buffer, size, NULL, GL_STREAM_DRAW);
+    return 1;
+}
+
+void scope_gl_stream_destroy(scope_gl_stream_t* stream) {
+    if (stream->mode == SCOPE_GL_STREAM_PERSISTENT) { scope_gl_ring_destroy(&stream->ring); }
+    else                                            { glDeleteBuffers(1, &stream->buffer); }
+    memset(stream, 0, sizeof(*stream));
+}
+
+/* the ring only aligns to 16, up to stride - 1 bytes in front of the range are skipped to reach a vertex boundary */
+void* scope_gl_stream_map(scope_gl_stream_t* stream, GLsizeiptr size, GLsizei stride, GLint* first) {
+    *first = 0;
+    if (stream->mode == SCOPE_GL_STREAM_PERSISTENT) {
+        void* ptr;
+        GLintptr offset = scope_gl_ring_alloc(&stream->ring, size + stride - 1, &ptr);
+        if (offset < 0) { return NULL; }
+        GLintptr pad = (stride - offset % stride) % stride;
+        *first = (GLint) ((offset + pad) / stride);
+        return (unsigned char*) ptr + pad;
+    }
+    if (stream->mapped || size > stream->size) { return NULL; }
+
+    GLintptr   offset = (stream->head + stride - 1) / stride * stride;
+    GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    if (stream->mode == SCOPE_GL_STREAM_ORPHAN || offset + size > stream->size) {
+        _scope_gl_buffer_data(stream->buffer, stream->size, NULL, GL_STREAM_DRAW); /* the GPU keeps reading the old storage */
+        stream->orphans++;
+        offset = 0;
+        access = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    }
+    void* ptr = _scope_gl_map_buffer(stream->buffer, offset, size, access);
+    if (!ptr) { return NULL; }
+    stream->head   = offset + size;
+    stream->mapped = 1;
+    *first = (GLint) (offset / stride);
+    return ptr;
+}
+
+void scope_gl_stream_unmap(scope_gl_stream_t* stream) {
+    if (!stream->mapped) { return; }
+    _scope_gl_unmap_buffer(stream->buffer);
+    stream->mapped = 0;
+}
+
+void scope_gl_stream_frame(scope_gl_stream_t* stream) {
+    if (stream->mode == SCOPE_GL_STREAM_PERSISTENT) { scope_gl_ring_frame(&stream->ring); }
+}
+
+#ifdef SCOPE_GL_SHADOW_STATE
+SCOPE_GL_THREAD_LOCAL scope_gl_context_t* _scope_gl_ctx;
+
+/* reads the groups in mask from the current GL context */
+static void _scope_gl_query_state(scope_gl_state_t* gl, GLuint mask) {
+    GLint v;
+    if (mask & SCOPE_GL_STATE_PROGRAM)        { glGetIntegerv(GL_CURRENT_PROGRAM,    &v); gl->program      = (GLuint) v; }
+    if (mask & SCOPE_GL_STATE_VERTEX_ARRAY)   { glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &v); gl->vertex_array = (GLuint) v; }
+    if (mask & SCOPE_GL_STATE_FRAMEBUFFER) {
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &v); gl->draw_framebuffer = (GLuint) v;
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &v); gl->read_framebuffer = (GLuint) v;
+    }
+    if (mask & SCOPE_GL_STATE_RENDERBUFFER)   { glGetIntegerv(GL_RENDERBUFFER_BINDING, &v); gl->renderbuffer   = (GLuint) v; }
+    if (mask & SCOPE_GL_STATE_BLEND_EQUATION) { glGetIntegerv(GL_BLEND_EQUATION_RGB,   &v); gl->blend_equation = (GLenum) v; }
+    if (mask & SCOPE_GL_STATE_BLEND_FUNC) {
+        glGetIntegerv(GL_BLEND_SRC_RGB, &v); gl->blend_src = (GLenum) v;
+        glGetIntegerv(GL_BLEND_DST_RGB, &v); gl->blend_dst = (GLenum) v;
+    }
+    if (mask & SCOPE_GL_STATE_CULL_FACE)      { glGetIntegerv(GL_CULL_FACE_MODE, &v); gl->cull_face  = (GLenum) v; }
+    if (mask & SCOPE_GL_STATE_FRONT_FACE)     { glGetIntegerv(GL_FRONT_FACE,     &v); gl->front_face = (GLenum) v; }
+    if (mask & SCOPE_GL_STATE_CLEAR_COLOR)    { glGetFloatv(GL_COLOR_CLEAR_VALUE,  gl->clear_color); }
+
+    if (mask & (SCOPE_GL_STATE_VIEWPORT | SCOPE_GL_STATE_SCISSOR)) {
+        GLint max_viewports = 0; /* stays 0 on contexts without viewport arrays */
+        glGetIntegerv(GL_MAX_VIEWPORTS, &max_viewports);
+        if (mask & SCOPE_GL_STATE_VIEWPORT) { glGetFloatv(GL_VIEWPORT,      gl->viewport[0]); gl->viewports = 1; }
+        if (mask & SCOPE_GL_STATE_SCISSOR)  { glGetIntegerv(GL_SCISSOR_BOX, gl->scissor[0]);  gl->scissors  = 1; }
+        for (GLuint i = 1; i < SCOPE_GL_MAX_VIEWPORTS && (GLint) i < max_viewports; i++) {
+            if (mask & SCOPE_GL_STATE_VIEWPORT) {
+                glGetFloati_v(GL_VIEWPORT, i, gl->viewport[i]);
+                if (memcmp(gl->viewport[i], gl->viewport[0], sizeof(gl->viewport[0])) != 0) { gl->viewports = i + 1; }
+            }
+            if (mask & SCOPE_GL_STATE_SCISSOR) {
+                glGetIntegeri_v(GL_SCISSOR_BOX, i, gl->scissor[i]);
+                if (memcmp(gl->scissor[i], gl->scissor[0], sizeof(gl->scissor[0])) != 0) { gl->scissors = i + 1; }
+            }
+        }
+    }
+
+    if (mask & SCOPE_GL_STATE_BUFFERS) {
+        #define _SCOPE_GL_SYNC_BUFFER(target, binding) \
+            glGetIntegerv(binding, &v); gl->buffers[_SCOPE_GL_BUF_##target] = (GLuint) v;
+        _SCOPE_GL_BUFFER_TARGETS(_SCOPE_GL_SYNC_BUFFER)
+        GLint max_ubo = 0;
+        glGetIntegerv(GL_MAX_UNIFORM_BUFFER_BINDINGS, &max_ubo);
+        for (GLuint i = 0; i < SCOPE_GL_MAX_BUFFER_BINDINGS; i++) {
+            GLint64* r = gl->uniform_blocks[i];
+            r[0] = r[1] = r[2] = 0;
+            if ((GLint) i >= max_ubo) { continue; }
+            glGetInteger64i_v(GL_UNIFORM_BUFFER_BINDING, i, &r[0]);
+            glGetInteger64i_v(GL_UNIFORM_BUFFER_START,   i, &r[1]);
+            glGetInteger64i_v(GL_UNIFORM_BUFFER_SIZE,    i, &r[2]);
+        }
+    }
+
+    if (mask & SCOPE_GL_STATE_SSBO) {
+        GLint max_ssbo = 0; /* stays 0 on contexts without shader storage buffers */
+        glGetIntegerv(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, &max_ssbo);
+        for (GLuint i = 0; i < SCOPE_GL_MAX_BUFFER_BINDINGS; i++) {
+            v = 0;
+            if ((GLint) i < max_ssbo) { glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, i, &v); }
+            gl->ssbo_bindings[i] = (GLuint) v;
+        }
+    }
+
+    if (mask & SCOPE_GL_STATE_CAPS) {
+        gl->caps = 0;
+        #define _SCOPE_GL_SYNC_CAP(cap) gl->caps |= (GLuint) (glIsEnabled(cap) == GL_TRUE) << _SCOPE_GL_CAP_##cap;
+        _SCOPE_GL_CAPS(_SCOPE_GL_SYNC_CAP)
+    }
+
+    /* texture and sampler bindings are per unit, so every unit has to be made active once */
+    if (mask & (SCOPE_GL_STATE_TEXTURES | SCOPE_GL_STATE_SAMPLERS)) {
+        GLint active;
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &active);
+        if (mask & SCOPE_GL_STATE_TEXTURES) { gl->active_texture = (GLuint) (active - GL_TEXTURE0); }
+        for (GLuint unit = 0; unit < SCOPE_GL_MAX_TEXTURE_UNITS; unit++) {
+            glActiveTexture(GL_TEXTURE0 + unit);
+            if (mask & SCOPE_GL_STATE_TEXTURES) {
+                #define _SCOPE_GL_SYNC_TEXTURE(target, binding) \
+                    glGetIntegerv(binding, &v); gl->textures[unit][_SCOPE_GL_TEX_##target] = (GLuint) v;
+                _SCOPE_GL_TEXTURE_TARGETS(_SCOPE_GL_SYNC_TEXTURE)
+            }
+            if (mask & SCOPE_GL_STATE_SAMPLERS) { glGetIntegerv(GL_SAMPLER_BINDING, &v); gl->samplers[unit] = (GLuint) v; }
+        }
+        glActiveTexture((GLenum) active);
+    }
+}
+
+void scope_gl_context_sync(scope_gl_context_t* ctx) {
+    memset(ctx->programs, 0, sizeof(ctx->programs));
+    ctx->uniform_top = 0;
+    ctx->dirty       = 0;
+    ctx->unknown     = 0;
+    _scope_gl_query_state(&ctx->gl, SCOPE_GL_STATE_ALL);
+    ctx->want = ctx->gl;
+    memset(ctx->vertex_arrays, 0, sizeof(ctx->vertex_arrays));
+    ctx->vertex_attribs = ctx->gl.vertex_array ? _scope_gl_query_vertex_attribs() : 0;
+}
+
+#ifdef SCOPE_GL_LAZY_STATE
+static void _scope_gl_copy_state(scope_gl_state_t* dst, const scope_gl_state_t* src, GLuint mask) {
+    #define _SCOPE_GL_COPY(group, field) if (mask & (group)) { memcpy(&dst->field, &src->field, sizeof(dst->field)); }
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_PROGRAM,        program)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_VERTEX_ARRAY,   vertex_array)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_TEXTURES,       active_texture)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_TEXTURES,       textures)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_SAMPLERS,       samplers)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_BUFFERS,        buffers)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_BUFFERS,        uniform_blocks)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_SSBO,           ssbo_bindings)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_FRAMEBUFFER,    draw_framebuffer)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_FRAMEBUFFER,    read_framebuffer)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_RENDERBUFFER,   renderbuffer)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_CAPS,           caps)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_VIEWPORT,       viewport)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_VIEWPORT,       viewports)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_SCISSOR,        scissor)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_SCISSOR,        scissors)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_CLEAR_COLOR,    clear_color)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_BLEND_FUNC,     blend_src)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_BLEND_FUNC,     blend_dst)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_BLEND_EQUATION, blend_equation)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_CULL_FACE,      cull_face)
+    _SCOPE_GL_COPY(SCOPE_GL_STATE_FRONT_FACE,     front_face)
+    #undef _SCOPE_GL_COPY
+}
+#endif
+
+/* re-reads the groups in mask, in lazy mode the scopes then want what the context has. Uniform values are only
+ * forgotten, they are read back one location at a time on their next push */
+void _scope_gl_resync(GLuint mask) {
+    scope_gl_context_t* ctx = _scope_gl_ctx;
+    _scope_gl_query_state(&ctx->gl, mask);
+    if (mask & SCOPE_GL_STATE_UNIFORMS) {
+        for (int i = 0; i < SCOPE_GL_MAX_PROGRAMS; i++) { memset(ctx->programs[i].known, 0, sizeof(ctx->programs[i].known)); }
+    }
+    if (mask & (SCOPE_GL_STATE_VERTEX_ARRAY | SCOPE_GL_STATE_VERTEX_ATTRIBS)) { /* NOTE: vertex array 0 has none (core profile) */
+        memset(ctx->vertex_arrays, 0, sizeof(ctx->vertex_arrays));
+        ctx->vertex_attribs = ctx->gl.vertex_array ? _scope_gl_query_vertex_attribs() : 0;
+        mask |= SCOPE_GL_STATE_VERTEX_ATTRIBS;
+    }
+#ifdef SCOPE_GL_LAZY_STATE
+    _scope_gl_copy_state(&ctx->want, &ctx->gl, mask);
+    ctx->dirty &= ~mask;
+#endif
+    ctx->unknown &= ~mask;
+}
+
+/* the GL context bound vao instead of old_vao: keeps the enabled attributes of old_vao and takes the ones of vao, a
+ * vertex array that was not seen before is queried on its first scope_glVertexAttribMask */
+void _scope_gl_switch_vertex_attribs(scope_gl_context_t* ctx, GLuint old_vao, GLuint vao) {
+    if (old_vao && !(ctx->unknown & SCOPE_GL_STATE_VERTEX_ATTRIBS)) {
+        for (GLuint n = 0, i = old_vao; n < SCOPE_GL_MAX_VERTEX_ARRAYS; n++, i++) { /* NOTE: dropped if full */
+            GLuint* e = ctx->vertex_arrays[i & (SCOPE_GL_MAX_VERTEX_ARRAYS - 1)];
+            if (e[0] == 0 || e[0] == old_vao) { e[0] = old_vao; e[1] = ctx->vertex_attribs; break; }
+        }
+    }
+    ctx->vertex_attribs = 0;
+    if (vao == 0) { ctx->unknown &= ~SCOPE_GL_STATE_VERTEX_ATTRIBS; return; } /* NOTE: has none (core profile) */
+    ctx->unknown |= SCOPE_GL_STATE_VERTEX_ATTRIBS;
+    for (GLuint n = 0, i = vao; n < SCOPE_GL_MAX_VERTEX_ARRAYS; n++, i++) {
+        const GLuint* e = ctx->vertex_arrays[i & (SCOPE_GL_MAX_VERTEX_ARRAYS - 1)];
+        if (e[0] == 0) { break; }
+        if (e[0] == vao) { ctx->vertex_attribs = e[1]; ctx->unknown &= ~SCOPE_GL_STATE_VERTEX_ATTRIBS; break; }
+    }
+}
+
+/* issues the gl* calls for all groups in mask where want differs from what the context has */
+void _scope_gl_apply_state(scope_gl_context_t* ctx, const scope_gl_state_t* want, GLuint mask) {
+    scope_gl_state_t* gl = &ctx->gl;
+    #define _SCOPE_GL_DIFFERS(group, differs) ((mask & (group)) && _scope_gl_changed(differs) && (_scope_gl_stat_group(sets, group), 1))
+
+    if (_SCOPE_GL_DIFFERS(SCOPE_GL_STATE_PROGRAM, gl->program != want->program)) {
+        glUseProgram(want->program); gl->program = want->program;
+    }
+    if (_SCOPE_GL_DIFFERS(SCOPE_GL_STATE_VERTEX_ARRAY, gl->vertex_array != want->vertex_array)) {
+        glBindVertexArray(want->vertex_array);
+        _scope_gl_switch_vertex_attribs(ctx, gl->vertex_array, want->vertex_array);
+        gl->vertex_array = want->vertex_array;
+    }
+    if (mask & SCOPE_GL_STATE_TEXTURES) {
+        for (GLuint unit = 0; unit < SCOPE_GL_MAX_TEXTURE_UNITS; unit++) {
+            for (int t = 0; t < _SCOPE_GL_TEXTURE_TARGET_COUNT; t++) {
+                if (gl->textures[unit][t] == want->textures[unit][t]) { continue; }
+                _scope_gl_stat(sets, SCOPE_GL_STAT_TEXTURES);
+#ifdef SCOPE_GL_DSA
+                if (want->textures[unit][t] != 0) { glBindTextureUnit(unit, want->textures[unit][t]); gl->textures[unit][t] = want->textures[unit][t]; continue; }
+#endif
+                if (gl->active_texture != unit) { glActiveTexture(GL_TEXTURE0 + unit); gl->active_texture = unit; _scope_gl_stat(sets, SCOPE_GL_STAT_TEXTURES); }
+                glBindTexture(_scope_gl_texture_targets[t], want->textures[unit][t]); gl->textures[unit][t] = want->textures[unit][t];
+            }
+        }
+        if (gl->active_texture != want->active_texture) { glActiveTexture(GL_TEXTURE0 + want->active_texture); gl->active_texture = want->active_texture; _scope_gl_stat(sets, SCOPE_GL_STAT_TEXTURES); }
+    }
+    if (mask & SCOPE_GL_STATE_SAMPLERS) {
+        for (GLuint unit = 0; unit < SCOPE_GL_MAX_TEXTURE_UNITS; unit++) {
+            if (gl->samplers[unit] == want->samplers[unit]) { continue; }
+            glBindSampler(unit, want->samplers[unit]); gl->samplers[unit] = want->samplers[unit];
+            _scope_gl_stat(sets, SCOPE_GL_STAT_SAMPLERS);
+        }
+    }
+    if (mask & SCOPE_GL_STATE_SSBO) { /* NOTE: before the generic bindings, glBindBufferBase changes them as well */
+        for (GLuint b = 0; b < SCOPE_GL_MAX_BUFFER_BINDINGS; b++) {
+            if (gl->ssbo_bindings[b] == want->ssbo_bindings[b]) { continue; }
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, b, want->ssbo_bindings[b]);
+            _scope_gl_stat(sets, SCOPE_GL_STAT_SSBO);
+            gl->ssbo_bindings[b] = gl->buffers[_SCOPE_GL_BUF_GL_SHADER_STORAGE_BUFFER] = want->ssbo_bindings[b];
+        }
+        mask |= SCOPE_GL_STATE_BUFFERS * (gl->buffers[_SCOPE_GL_BUF_GL_SHADER_STORAGE_BUFFER] != want->buffers[_SCOPE_GL_BUF_GL_SHADER_STORAGE_BUFFER]);
+    }
+    if (mask & SCOPE_GL_STATE_BUFFERS) {
+        for (int t = 0; t < _SCOPE_GL_BUFFER_TARGET_COUNT; t++) {
+            if (gl->buffers[t] == want->buffers[t]) { continue; }
+            glBindBuffer(_scope_gl_buffer_targets[t], want->buffers[t]); gl->buffers[t] = want->buffers[t];
+            _scope_gl_stat(sets, SCOPE_GL_STAT_BUFFERS);
+        }
+    }
+    if (_SCOPE_GL_DIFFERS(SCOPE_GL_STATE_FRAMEBUFFER, gl->draw_framebuffer != want->draw_framebuffer || gl->read_framebuffer != want->read_framebuffer)) {
+        if (want->draw_framebuffer == want->read_framebuffer) {
+            glBindFramebuffer(GL_FRAMEBUFFER, want->draw_framebuffer);
+        } else {
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, want->draw_framebuffer);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, want->read_framebuffer);
+        }
+        gl->draw_framebuffer = want->draw_framebuffer; gl->read_framebuffer = want->read_framebuffer;
+    }
+    if (_SCOPE_GL_DIFFERS(SCOPE_GL_STATE_RENDERBUFFER, gl->renderbuffer != want->renderbuffer)) {
+        glBindRenderbuffer(GL_RENDERBUFFER, want->renderbuffer); gl->renderbuffer = want->renderbuffer;
+    }
+    if (mask & SCOPE_GL_STATE_CAPS) {
+        for (GLuint diff = gl->caps ^ want->caps; diff; diff &= diff - 1) {
+            int c = _scope_gl_ctz(diff);
+            if ((want->caps >> c) & 1) { glEnable(_scope_gl_caps[c]); } else { glDisable(_scope_gl_caps[c]); }
+            _scope_gl_stat(sets, SCOPE_GL_STAT_CAPS);
+        }
+        gl->caps = want->caps;
+    }
+    /* arrays go out whole, one call either way */
+    if (_SCOPE_GL_DIFFERS(SCOPE_GL_STATE_VIEWPORT, _scope_gl_rects_differ(gl->viewport, gl->viewports, want->viewport, want->viewports))) {
+        const GLfloat* v = want->viewport[0];
+        _scope_gl_fill_rects(gl->viewport, want->viewport, want->viewports);
+        gl->viewports = want->viewports;
+        if (gl->viewports > 1) { glViewportArrayv(0, SCOPE_GL_MAX_VIEWPORTS, gl->viewport[0]); }
+        else                   { glViewport((GLint) v[0], (GLint) v[1], (GLsizei) v[2], (GLsizei) v[3]); }
+    }
+    if (_SCOPE_GL_DIFFERS(SCOPE_GL_STATE_SCISSOR, _scope_gl_rects_differ(gl->scissor, gl->scissors, want->scissor, want->scissors))) {
+        const GLint* s = want->scissor[0];
+        _scope_gl_fill_rects(gl->scissor, want->scissor, want->scissors);
+        gl->scissors = want->scissors;
+        if (gl->scissors > 1) { glScissorArrayv(0, SCOPE_GL_MAX_VIEWPORTS, gl->scissor[0]); }
+        else                  { glScissor(s[0], s[1], s[2], s[3]); }
+    }
+    if (_SCOPE_GL_DIFFERS(SCOPE_GL_STATE_CLEAR_COLOR, memcmp(gl->clear_color, want->clear_color, sizeof(gl->clear_color)) != 0)) {
+        glClearColor(want->clear_color[0], want->clear_color[1], want->clear_color[2], want->clear_color[3]);
+        memcpy(gl->clear_color, want->clear_color, sizeof(gl->clear_color));
+    }
+    if (_SCOPE_GL_DIFFERS(SCOPE_GL_STATE_BLEND_FUNC, gl->blend_src != want->blend_src || gl->blend_dst != want->blend_dst)) {
+        glBlendFunc(want->blend_src, want->blend_dst); gl->blend_src = want->blend_src; gl->blend_dst = want->blend_dst;
+    }
+    if (_SCOPE_GL_DIFFERS(SCOPE_GL_STATE_BLEND_EQUATION, gl->blend_equation != want->blend_equation)) {
+        glBlendEquation(want->blend_equation); gl->blend_equation = want->blend_equation;
+    }
+    if (_SCOPE_GL_DIFFERS(SCOPE_GL_STATE_CULL_FACE, gl->cull_face != want->cull_face)) {
+        glCullFace(want->cull_face); gl->cull_face = want->cull_face;
+    }
+    if (_SCOPE_GL_DIFFERS(SCOPE_GL_STATE_FRONT_FACE, gl->front_face != want->front_face)) {
+        glFrontFace(want->front_face); gl->front_face = want->front_face;
+    }
+}
+
+/* prev gets the same masks as block and the values block is about to overwrite (unset values without
+ * SCOPE_GL_RESTORE_STATE), then block is applied */
+scope_gl_state_block_t* _scope_gl_push_state_block(scope_gl_state_block_t* prev, scope_gl_state_block_t* block) {
+    const scope_gl_state_t* gl = _scope_gl_known(block->mask);
+    scope_gl_state_t* p = &prev->state;
+    prev->mask        = block->mask;
+    prev->caps_mask   = block->caps_mask;
+    prev->buffer_mask = block->buffer_mask;
+    prev->ssbo_mask   = block->ssbo_mask;
+
+#ifdef SCOPE_GL_RESTORE_STATE
+    if (block->mask & SCOPE_GL_STATE_TEXTURES) {
+        for (GLuint unit = 0; unit < SCOPE_GL_MAX_TEXTURE_UNITS; unit++) {
+            prev->texture_mask[unit] = block->texture_mask[unit];
+            for (GLuint m = block->texture_mask[unit]; m; m &= m - 1) { int t = _scope_gl_ctz(m); p->textures[unit][t] = gl->textures[unit][t]; }
+        }
+    }
+    for (GLuint m = block->buffer_mask; m; m &= m - 1) { int t = _scope_gl_ctz(m); p->buffers[t] = gl->buffers[t]; }
+    for (GLuint m = block->ssbo_mask;   m; m &= m - 1) { int b = _scope_gl_ctz(m); p->ssbo_bindings[b] = gl->ssbo_bindings[b]; }
+    p->program          = gl->program;
+    p->vertex_array     = gl->vertex_array;
+    p->draw_framebuffer = gl->draw_framebuffer;
+    p->read_framebuffer = gl->read_framebuffer;
+    p->caps             = gl->caps;
+    memcpy(p->viewport,    gl->viewport,    sizeof(p->viewport));
+    memcpy(p->scissor,     gl->scissor,     sizeof(p->scissor));
+    p->viewports        = gl->viewports;
+    p->scissors         = gl->scissors;
+    memcpy(p->clear_color, gl->clear_color, sizeof(p->clear_color));
+    p->blend_src        = gl->blend_src;
+    p->blend_dst        = gl->blend_dst;
+    p->blend_equation   = gl->blend_equation;
+    p->cull_face        = gl->cull_face;
+    p->front_face       = gl->front_face;
+#else
+    /* same values the _unset_* scopes reset to */
+    (void) gl;
+    memset(p, 0, sizeof(*p));
+    if (block->mask & SCOPE_GL_STATE_TEXTURES) { memcpy(prev->texture_mask, block->texture_mask, sizeof(prev->texture_mask)); }
+    p->viewports = p->scissors = 1;
+    p->scissor[0][2] = p->scissor[0][3] = 1000000000;
+    p->blend_equation = GL_FUNC_ADD;
+    p->cull_face      = GL_BACK;
+    p->front_face     = GL_CCW;
+#endif
+
+    _scope_gl_apply_state_block(block);
+    return block;
+}
+
+/* applies the fields of block through the setters, so only what differs from the tracked state is changed */
+void _scope_gl_apply_state_block(const scope_gl_state_block_t* block) {
+    const scope_gl_state_t* b = &block->state;
+    GLuint mask = block->mask;
+    _scope_gl_known(mask);
+
+    if (mask & SCOPE_GL_STATE_PROGRAM)      { _scope_gl_use_program(b->program); }
+    if (mask & SCOPE_GL_STATE_VERTEX_ARRAY) { _scope_gl_bind_vertex_array(b->vertex_array); }
+    if (mask & SCOPE_GL_STATE_TEXTURES) {
+        GLuint active = _scope_gl_tracked()->active_texture;
+        for (GLuint unit = 0; unit < SCOPE_GL_MAX_TEXTURE_UNITS; unit++) {
+            for (GLuint m = block->texture_mask[unit]; m; m &= m - 1) {
+                int t = _scope_gl_ctz(m);
+                if (_scope_gl_tracked()->textures[unit][t] == b->textures[unit][t]) { continue; }
+#ifdef SCOPE_GL_DSA
+                if (b->textures[unit][t] != 0) { _scope_gl_bind_texture_unit(unit, t, b->textures[unit][t]); continue; }
+#endif
+                _scope_gl_active_texture(unit);
+                _scope_gl_bind_texture(_scope_gl_texture_targets[t], b->textures[unit][t]);
+            }
+        }
+        _scope_gl_active_texture(active);
+    }
+    for (GLuint m = block->ssbo_mask;   m; m &= m - 1) { int i = _scope_gl_ctz(m); _scope_gl_bind_ssbo(b->ssbo_bindings[i], (GLuint) i, NULL); }
+    for (GLuint m = block->buffer_mask; m; m &= m - 1) { int t = _scope_gl_ctz(m); _scope_gl_bind_buffer(_scope_gl_buffer_targets[t], b->buffers[t]); }
+    if (mask & SCOPE_GL_STATE_FRAMEBUFFER) {
+        if (b->draw_framebuffer == b->read_framebuffer) { _scope_gl_bind_framebuffer(GL_FRAMEBUFFER, b->draw_framebuffer); }
+        else { _scope_gl_bind_framebuffer(GL_DRAW_FRAMEBUFFER, b->draw_framebuffer); _scope_gl_bind_framebuffer(GL_READ_FRAMEBUFFER, b->read_framebuffer); }
+    }
+    if (mask & SCOPE_GL_STATE_CAPS) {
+        for (GLuint m = block->caps_mask & (b->caps ^ _scope_gl_tracked()->caps); m; m &= m - 1) {
+            int c = _scope_gl_ctz(m);
+            _scope_gl_enable(_scope_gl_caps[c], (GLboolean) ((b->caps >> c) & 1));
+        }
+    }
+    if (mask & SCOPE_GL_STATE_VIEWPORT) {
+        const GLfloat* v = b->viewport[0];
+        if (b->viewports > 1) { GLfloat rects[SCOPE_GL_MAX_VIEWPORTS][4]; _scope_gl_fill_rects(rects, b->viewport, b->viewports); _scope_gl_viewport_array(0, SCOPE_GL_MAX_VIEWPORTS, rects[0], NULL); }
+        else                  { _scope_gl_viewport((GLint) v[0], (GLint) v[1], (GLsizei) v[2], (GLsizei) v[3], NULL); }
+    }
+    if (mask & SCOPE_GL_STATE_SCISSOR) {
+        const GLint* s = b->scissor[0];
+        if (b->scissors > 1) { GLint rects[SCOPE_GL_MAX_VIEWPORTS][4]; _scope_gl_fill_rects(rects, b->scissor, b->scissors); _scope_gl_scissor_array(0, SCOPE_GL_MAX_VIEWPORTS, rects[0], NULL); }
+        else                 { _scope_gl_scissor(s[0], s[1], s[2], s[3], NULL); }
+    }
+    if (mask & SCOPE_GL_STATE_CLEAR_COLOR)    { _scope_gl_clear_color(b->clear_color[0], b->clear_color[1], b->clear_color[2], b->clear_color[3], NULL); }
+    if (mask & SCOPE_GL_STATE_BLEND_FUNC)     { _scope_gl_blend_func(b->blend_src, b->blend_dst, NULL); }
+    if (mask & SCOPE_GL_STATE_BLEND_EQUATION) { _scope_gl_blend_equation(b->blend_equation); }
+    if (mask & SCOPE_GL_STATE_CULL_FACE)      { _scope_gl_cull_face(b->cull_face); }
+    if (mask & SCOPE_GL_STATE_FRONT_FACE)     { _scope_gl_front_face(b->front_face); }
+}
+
+/* command buffers: snapshots and uniform scopes are allocated from the start of the memory, commands from the end */
+#define _scope_gl_cmds_end(cmdbuf) ((scope_gl_cmd_t*) ((cmdbuf)->memory + (cmdbuf)->size)) /* command i is at [-1 - i] */
+
+void scope_gl_cmdbuf_init(scope_gl_cmdbuf_t* cmdbuf, void* memory, size_t size) {
+    memset(cmdbuf, 0, sizeof(*cmdbuf));
+    cmdbuf->memory = (unsigned char*) memory;
+    cmdbuf->size   = size - size % sizeof(scope_gl_cmd_t); /* keeps the commands aligned */
+}
+
+void scope_gl_cmdbuf_reset(scope_gl_cmdbuf_t* cmdbuf) {
+    cmdbuf->head        = 0;
+    cmdbuf->count       = 0;
+    cmdbuf->dropped     = 0;
+    cmdbuf->state       = NULL;
+    cmdbuf->uniforms    = NULL;
+    cmdbuf->pass        = 0;
+    cmdbuf->framebuffer = 0;
+}
+
+static void* _scope_gl_cmdbuf_alloc(scope_gl_cmdbuf_t* cmdbuf, size_t size) {
+    size = (size + 7) & ~(size_t) 7;
+    if (cmdbuf->head + size > cmdbuf->size - cmdbuf->count * sizeof(scope_gl_cmd_t)) { cmdbuf->dropped++; return NULL; }
+    void* p = cmdbuf->memory + cmdbuf->head;
+    cmdbuf->head += size;
+    return p;
+}
+
+/* [63..52] pass, [51] GL_BLEND, [50..35] program, [34..19] hash of all texture bindings, [18..3] vertex array.
+ * Blended draws only get the flag, _scope_gl_record() puts the recording order below it */
+static uint64_t _scope_gl_state_key(const scope_gl_state_t* s) {
+    if ((s->caps >> _SCOPE_GL_CAP_GL_BLEND) & 1) { return (uint64_t) 1 << 51; }
+    const GLuint* t = &s->textures[0][0];
+    GLuint h = 2166136261u;
+    for (size_t i = 0; i < sizeof(s->textures) / sizeof(GLuint); i++) { h = (h ^ t[i]) * 16777619u; }
+    return ((uint64_t) (s->program & 0xffff) << 35) | ((uint64_t) ((h ^ (h >> 16)) & 0xffff) << 19) | ((uint64_t) (s->vertex_array & 0xffff) << 3);
+}
+
+/* ctx->dirty is reused to tell if the scopes changed state since the last recorded command */
+scope_gl_cmdbuf_t* _scope_gl_begin_record(scope_gl_cmdbuf_t* cmdbuf) {
+    scope_gl_context_t* ctx = _scope_gl_ctx;
+    if (ctx->unknown) { _scope_gl_resync(ctx->unknown); } /* the snapshots copy all of want */
+    if (ctx->batching) { _scope_gl_batch_submit(ctx->batching); }
+    cmdbuf->dirty    = ctx->dirty;
+    cmdbuf->state    = NULL;
+    cmdbuf->uniforms = NULL;
+    ctx->recording   = cmdbuf;
+    return cmdbuf;
+}
+
+void _scope_gl_end_record(scope_gl_cmdbuf_t* cmdbuf) {
+    scope_gl_context_t* ctx = _scope_gl_ctx;
+    ctx->recording = NULL;
+    ctx->dirty     = cmdbuf->dirty; /* the scopes inside are balanced, so want is back to what it was */
+}
+
+int scope_gl_batch_init(scope_gl_batch_t* batch, GLsizeiptr size) {
+    memset(batch, 0, sizeof(*batch));
+    return scope_gl_ring_init(&batch->ring, GL_DRAW_INDIRECT_BUFFER, size);
+}
+
+void scope_gl_batch_destroy(scope_gl_batch_t* batch) {
+    scope_gl_ring_destroy(&batch->ring);
+    memset(batch, 0, sizeof(*batch));
+}
+
+void scope_gl_batch_frame(scope_gl_batch_t* batch) { scope_gl_ring_frame(&batch->ring); }
+
+/* an enclosing batch goes out first, so the draws keep their order */
+scope_gl_batch_t* _scope_gl_begin_batch(scope_gl_batch_t* batch) {
+    scope_gl_context_t* ctx = _scope_gl_ctx;
+    scope_gl_batch_t* prev = ctx->batching;
+    if (prev) { _scope_gl_batch_submit(prev); }
+    batch->count   = 0;
+    ctx->batching  = batch;
+    return prev;
+}
+
+void _scope_gl_end_batch(scope_gl_batch_t* batch, scope_gl_batch_t* prev) {
+    _scope_gl_batch_submit(batch);
+    _scope_gl_ctx->batching = prev;
+}
+
+/* NOTE: the indirect buffer is bound behind want, the next flush of SCOPE_GL_STATE_BUFFERS puts back what the scopes asked for */
+void _scope_gl_batch_submit(scope_gl_batch_t* batch) {
+    scope_gl_context_t* ctx = _scope_gl_ctx;
+    GLsizei n = batch->count;
+    if (n == 0) { return; }
+    batch->count = 0;
+    batch->submits++;
+
+    const size_t stride = (batch->type ? 5 : 4) * sizeof(GLuint);
+    void* dst;
+    GLintptr offset = scope_gl_ring_alloc(&batch->ring, (GLsizeiptr) (n * stride), &dst);
+    if (offset < 0) {
+        for (GLsizei i = 0; i < n; i++) {
+            const GLuint* c = batch->commands[i];
+            GLuint size = (batch->type == GL_UNSIGNED_BYTE) ? 1 : (batch->type == GL_UNSIGNED_SHORT) ? 2 : 4;
+            if (batch->type) { glDrawElementsInstancedBaseVertexBaseInstance(batch->mode, (GLsizei) c[0], batch->type, (const void*) ((uintptr_t) c[2] * size), (GLsizei) c[1], (GLint) c[3], c[4]); }
+            else             { glDrawArraysInstancedBaseInstance(batch->mode, (GLint) c[2], (GLsizei) c[0], (GLsizei) c[1], c[3]); }
+        }
+        return;
+    }
+    for (GLsizei i = 0; i < n; i++) { memcpy((unsigned char*) dst + i * stride, batch->commands[i], stride); }
+
+    GLuint* bound = &ctx->gl.buffers[_SCOPE_GL_BUF_GL_DRAW_INDIRECT_BUFFER];
+    if (*bound != batch->ring.buffer) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, batch->ring.buffer);
+        _scope_gl_stat(sets, SCOPE_GL_STAT_BUFFERS);
+        *bound = batch->ring.buffer;
+        ctx->dirty |= SCOPE_GL_STATE_BUFFERS;
+    }
+    if (batch->type) { glMultiDrawElementsIndirect(batch->mode, batch->type, (const void*) offset, n, 0); }
+    else             { glMultiDrawArraysIndirect(batch->mode, (const void*) offset, n, 0); }
+}
+
+/* draws under the state of the previous one are appended, anything else first applies what the scopes asked for */
+static void _scope_gl_batch_draw(scope_gl_batch_t* batch, int kind, GLenum mode, GLint first, GLsizei count, GLenum type, const void* indices) {
+    scope_gl_context_t* ctx = _scope_gl_ctx;
+    if (kind == _SCOPE_GL_CMD_CLEAR) { scope_glFlushState(); glClear(mode); return; }
+    if (kind == _SCOPE_GL_CMD_DRAW_ARRAYS) { type = 0; }
+    if (ctx->dirty || batch->count == SCOPE_GL_MAX_BATCH || batch->mode != mode || batch->type != type) {
+        scope_glFlushState(); /* NOTE: submits the batch */
+        batch->mode = mode;
+        batch->type = type;
+    }
+    GLuint* c = batch->commands[batch->count];
+    GLuint  i = (GLuint) batch->count++;
+    batch->draws++;
+    if (type) {
+        GLuint size = (type == GL_UNSIGNED_BYTE) ? 1 : (type == GL_UNSIGNED_SHORT) ? 2 : 4;
+        c[0] = (GLuint) count; c[1] = 1; c[2] = (GLuint) ((uintptr_t) indices / size); c[3] = 0; c[4] = i;
+    } else {
+        c[0] = (GLuint) count; c[1] = 1; c[2] = (GLuint) first; c[3] = i;
+    }
+}
+
+void _scope_gl_record(int kind, GLenum mode, GLint first, GLsizei count, GLenum type, const void* indices) {
+    scope_gl_context_t* ctx = _scope_gl_ctx;
+    scope_gl_cmdbuf_t* cmdbuf = ctx->recording;
+    if (!cmdbuf) { _scope_gl_batch_draw(ctx->batching, kind, mode, first, count, type, indices); return; }
+    if (!cmdbuf->state || ctx->dirty) {
+        scope_gl_state_t* snapshot = (scope_gl_state_t*) _scope_gl_cmdbuf_alloc(cmdbuf, sizeof(*snapshot));
+        if (!snapshot) { return; }
+        *snapshot = ctx->want;
+        cmdbuf->state     = snapshot;
+        cmdbuf->state_key = _scope_gl_state_key(snapshot);
+        ctx->dirty        = 0;
+    }
+    if (cmdbuf->head + sizeof(scope_gl_cmd_t) > cmdbuf->size - cmdbuf->count * sizeof(scope_gl_cmd_t)) { cmdbuf->dropped++; return; }
+
+    if (kind == _SCOPE_GL_CMD_CLEAR || cmdbuf->state->draw_framebuffer != cmdbuf->framebuffer) { /* new pass */
+        cmdbuf->pass       += (cmdbuf->pass < 0xfff);
+        cmdbuf->framebuffer = cmdbuf->state->draw_framebuffer;
+    }
+    uint64_t key = cmdbuf->state_key;
+    if (key >> 51)                     { key |= cmdbuf->count; } /* blended, keep the order */
+    if (kind == _SCOPE_GL_CMD_CLEAR)   { key = 0; }              /* first in its pass */
+
+    scope_gl_cmd_t* cmd = &_scope_gl_cmds_end(cmdbuf)[-1 - (ptrdiff_t) cmdbuf->count++];
+    cmd->key      = ((uint64_t) cmdbuf->pass << 52) | key;
+    cmd->state    = cmdbuf->state;
+    cmd->uniforms = cmdbuf->uniforms;
+    cmd->kind     = kind;
+    cmd->mode     = mode;
+    cmd->first    = first;
+    cmd->count    = count;
+    cmd->type     = type;
+    cmd->indices  = indices;
+}
+
+/* called after _scope_gl_uniform_push() changed the shadowed values, the old ones are still on the uniform stack */
+void _scope_gl_record_uniform(GLint location, GLsizei count, int comps, const void* values, GLint top, void (*upload)(GLint, GLsizei, const void*)) {
+    scope_gl_context_t* ctx = _scope_gl_ctx;
+    scope_gl_cmdbuf_t* cmdbuf = ctx->recording;
+    size_t words = (size_t) count * comps;
+    if (top < 0) { cmdbuf->dropped++; return; } /* NOTE: without the old values the scope cannot be replayed */
+
+    scope_gl_uniform_cmd_t* u = (scope_gl_uniform_cmd_t*) _scope_gl_cmdbuf_alloc(cmdbuf, sizeof(*u) + 2 * words * sizeof(GLuint));
+    if (!u) { return; }
+    GLuint* v = (GLuint*) (u + 1);
+    memcpy(v,         values,                    words * sizeof(GLuint));
+    memcpy(v + words, &ctx->uniform_stack[top], words * sizeof(GLuint));
+    u->prev     = cmdbuf->uniforms;
+    u->upload   = upload;
+    u->program  = ctx->want.program;
+    u->location = location;
+    u->count    = count;
+    u->comps    = comps;
+    u->top      = top;
+    u->depth    = u->prev ? u->prev->depth + 1 : 1;
+    u->values   = v;
+    cmdbuf->uniforms = u;
+}
+
+void _scope_gl_record_uniform_pop(GLint top) {
+    scope_gl_cmdbuf_t* cmdbuf = _scope_gl_ctx->recording;
+    if (cmdbuf->uniforms && cmdbuf->uniforms->top == top) { cmdbuf->uniforms = cmdbuf->uniforms->prev; }
+}
+
+/* uploads values for a recorded uniform scope if they differ from the per-program value store */
+static void _scope_gl_replay_uniform(scope_gl_context_t* ctx, const scope_gl_uniform_cmd_t* u, const GLuint* values) {
+    scope_gl_program_t* prog = _scope_gl_program(u->program);
+    int changed = 0;
+    for (GLsizei e = 0; e < u->count; e++) {
+        GLint l = u->location + e;
+        const GLuint* v = values + e * u->comps;
+        if (l >= SCOPE_GL_MAX_UNIFORM_LOCATIONS) { changed = 1; continue; }
+        if ((prog->known[l / 32] & (1u << (l % 32))) && memcmp(prog->values[l], v, u->comps * sizeof(GLuint)) == 0) { continue; }
+        memcpy(prog->values[l], v, u->comps * sizeof(GLuint));
+        prog->known[l / 32] |= 1u << (l % 32);
+        changed = 1;
+    }
+    if (!_scope_gl_changed(changed)) { _scope_gl_stat(skipped, SCOPE_GL_STAT_UNIFORMS); return; }
+    if (ctx->gl.program != u->program) { glUseProgram(u->program); ctx->gl.program = u->program; _scope_gl_stat(sets, SCOPE_GL_STAT_PROGRAM); }
+    _scope_gl_stat(sets, SCOPE_GL_STAT_UNIFORMS);
+    u->upload(u->location, u->count, values);
+}
+
+static void _scope_gl_replay_uniforms(scope_gl_context_t* ctx, const scope_gl_uniform_cmd_t* u, const scope_gl_uniform_cmd_t* stop) {
+    if (u == stop) { return; }
+    _scope_gl_replay_uniforms(ctx, u->prev, stop); /* outermost first */
+    _scope_gl_replay_uniform(ctx, u, u->values);
+}
+
+/* leaves the recorded uniform scopes of from up to the innermost one shared with to, then enters the rest of to */
+static void _scope_gl_switch_uniforms(scope_gl_context_t* ctx, const scope_gl_uniform_cmd_t* from, const scope_gl_uniform_cmd_t* to) {
+    const scope_gl_uniform_cmd_t *a = from, *b = to;
+    while (a != b) { if (!b || (a && a->depth >= b->depth)) { a = a->prev; } else { b = b->prev; } }
+    for (; from != a; from = from->prev) { _scope_gl_replay_uniform(ctx, from, from->values + from->count * from->comps); }
+    _scope_gl_replay_uniforms(ctx, to, a);
+}
+
+typedef struct _scope_gl_sort_item_t { uint64_t key; GLuint index; } _scope_gl_sort_item_t;
+
+/* stable radix sort of the keys (in the free memory between state and commands, replayed unsorted if it does not fit),
+ * then every command gets its state applied through the diff in _scope_gl_apply_state() */
+void scope_gl_cmdbuf_submit(scope_gl_cmdbuf_t* cmdbuf) {
+    scope_gl_context_t* ctx = _scope_gl_ctx;
+    const scope_gl_cmd_t* end = _scope_gl_cmds_end(cmdbuf);
+    GLuint n = cmdbuf->count;
+    if (n == 0) { scope_gl_cmdbuf_reset(cmdbuf); return; }
+    if (ctx->batching) { _scope_gl_batch_submit(ctx->batching); }
+
+    _scope_gl_sort_item_t* items = NULL;
+    if (2 * n * sizeof(_scope_gl_sort_item_t) <= cmdbuf->size - n * sizeof(scope_gl_cmd_t) - cmdbuf->head) {
+        items = (_scope_gl_sort_item_t*) (cmdbuf->memory + cmdbuf->head);
+        _scope_gl_sort_item_t* tmp = items + n;
+        for (GLuint i = 0; i < n; i++) { items[i].key = end[-1 - (ptrdiff_t) i].key; items[i].index = i; }
+        for (int shift = 0; shift < 64; shift += 8) {
+            GLuint hist[256] = {0};
+            for (GLuint i = 0; i < n; i++) { hist[(items[i].key >> shift) & 0xff]++; }
+            if (hist[(items[0].key >> shift) & 0xff] == n) { continue; } /* same byte everywhere */
+            for (GLuint b = 0, sum = 0; b < 256; b++) { GLuint c = hist[b]; hist[b] = sum; sum += c; }
+            for (GLuint i = 0; i < n; i++) { tmp[hist[(items[i].key >> shift) & 0xff]++] = items[i]; }
+            _scope_gl_sort_item_t* swap = items; items = tmp; tmp = swap;
+        }
+    }
+
+    const scope_gl_state_t*       state    = NULL;
+    const scope_gl_uniform_cmd_t* uniforms = NULL;
+    for (GLuint i = 0; i < n; i++) {
+        const scope_gl_cmd_t* cmd = &end[-1 - (ptrdiff_t) (items ? items[i].index : i)];
+        GLuint mask = (cmd->state != state) ? SCOPE_GL_STATE_ALL : 0;
+        if (cmd->uniforms != uniforms) {
+            _scope_gl_switch_uniforms(ctx, uniforms, cmd->uniforms);
+            uniforms = cmd->uniforms;
+            mask |= SCOPE_GL_STATE_PROGRAM; /* uploads may have bound another program */
+        }
+        if (mask) { _scope_gl_apply_state(ctx, cmd->state, mask); state = cmd->state; }
+        switch (cmd->kind) {
+            case _SCOPE_GL_CMD_DRAW_ARRAYS:   glDrawArrays(cmd->mode, cmd->first, cmd->count);                   break;
+            case _SCOPE_GL_CMD_DRAW_ELEMENTS: glDrawElements(cmd->mode, cmd->count, cmd->type, cmd->indices);    break;
+            case _SCOPE_GL_CMD_CLEAR:         glClear(cmd->mode);                                                break;
+        }
+    }
+    _scope_gl_switch_uniforms(ctx, uniforms, NULL);
+    ctx->dirty = SCOPE_GL_STATE_ALL; /* gl has the state of the last command, want is untouched */
+    scope_gl_cmdbuf_reset(cmdbuf);
+}
+
+/* open addressing on the program id, a full table evicts the home slot of the new program */
+scope_gl_program_t* _scope_gl_program(GLuint program) {
+    scope_gl_program_t* programs = _scope_gl_ctx->programs;
+    unsigned home = (program * 2654435761u) & (SCOPE_GL_MAX_PROGRAMS - 1);
+    for (unsigned n = 0; n < SCOPE_GL_MAX_PROGRAMS; n++) {
+        scope_gl_program_t* p = &programs[(home + n) & (SCOPE_GL_MAX_PROGRAMS - 1)];
+        if (p->id == program) { return p; }
+        if (p->id == 0) { p->id = program; return p; }
+    }
+    memset(&programs[home], 0, sizeof(programs[home]));
+    programs[home].id = program;
+    return &programs[home];
+}
+
+void scope_gl_invalidate_program(GLuint program) {
+    scope_gl_program_t* p = _scope_gl_program(program);
+    memset(p->uniforms, 0, sizeof(p->uniforms));
+    memset(p->known,    0, sizeof(p->known));
+}
+
+/* NOTE: with the table full the program is bound as is, i.e. its first use waits for the link */
+void scope_gl_program_building(GLuint program, GLuint placeholder) {
+    scope_gl_context_t* ctx = _scope_gl_ctx;
+    scope_gl_program_ready(program);
+    if (ctx->building_count == SCOPE_GL_MAX_BUILDING) { return; }
+    ctx->building[ctx->building_count][0] = program;
+    ctx->building[ctx->building_count][1] = placeholder;
+    ctx->building_count++;
+}
+
+/* NOTE: with the table full the program keeps binding its textures */
+void scope_gl_program_bindless(GLuint program, int bindless) {
+    scope_gl_context_t* ctx = _scope_gl_ctx;
+    for (GLuint i = 0; i < ctx->bindless_count; i++) {
+        if (ctx->bindless[i] != program) { continue; }
+        if (!bindless) { ctx->bindless[i] = ctx->bindless[--ctx->bindless_count]; }
+        return;
+    }
+    if (bindless && ctx->bindless_count < SCOPE_GL_MAX_BINDLESS) { ctx->bindless[ctx->bindless_count++] = program; }
+}
+
+void scope_gl_program_ready(GLuint program) {
+    scope_gl_context_t* ctx = _scope_gl_ctx;
+    for (GLuint i = 0; i < ctx->building_count; i++) {
+        if (ctx->building[i][0] != program) { continue; }
+        ctx->building_count--;
+        ctx->building[i][0] = ctx->building[ctx->building_count][0];
+        ctx->building[i][1] = ctx->building[ctx->building_count][1];
+        return;
+    }
+}
+
+/* the locations are still right, a new name only costs one glGetUniformLocation */
+void scope_gl_forget_uniform_names(void) {
+    for (int i = 0; i < SCOPE_GL_MAX_PROGRAMS; i++) { memset(_scope_gl_ctx->programs[i].uniforms, 0, sizeof(_scope_gl_ctx->programs[i].uniforms)); }
+}
+
+GLint _scope_gl_uniform_location_miss(scope_gl_program_t* prog, const char* name) {
+    unsigned home = _scope_gl_hash_ptr(name) & (SCOPE_GL_MAX_UNIFORMS - 1);
+    scope_gl_uniform_t* slot = &prog->uniforms[home];
+    for (unsigned n = 0; n < SCOPE_GL_MAX_UNIFORMS; n++) {
+        scope_gl_uniform_t* u = &prog->uniforms[(home + n) & (SCOPE_GL_MAX_UNIFORMS - 1)];
+        if (u->name == name) { return u->location; }
+        if (u->name == NULL) { slot = u; break; }
+    }
+    slot->name     = name; /* NOTE: overwrites the home slot when full */
+    slot->location = glGetUniformLocation(prog->id, name);
+    _scope_gl_stat(queries, SCOPE_GL_STAT_UNIFORMS);
+    return slot->location;
+}
+
+/* pushes the shadowed values at location..location+count-1 onto the uniform stack and stores the new ones. Values that
+ * are not known yet are read back once, so after the first use of a uniform no more glGetUniform* calls happen */
+GLint _scope_gl_uniform_push(GLint location, GLsizei count, int comps, int is_int, const void* values, int* changed) {
+    scope_gl_context_t* ctx = _scope_gl_ctx;
+    *changed = 0;
+    if (location < 0) { return -1; }
+
+    scope_gl_program_t* prog = _scope_gl_program(_scope_gl_known(SCOPE_GL_STATE_PROGRAM | SCOPE_GL_STATE_UNIFORMS)->program);
+    GLint top = -1; /* NOTE: old values are not saved (and not restored) when the stack is full */
+    if (ctx->uniform_top + count * comps <= SCOPE_GL_UNIFORM_STACK_SIZE) { top = ctx->uniform_top; ctx->uniform_top += count * comps; }
+
+    const GLuint* src = (const GLuint*) values;
+    for (GLsizei e = 0; e < count; e++, src += comps) {
+        GLint  l = location + e;
+        GLuint scratch[16];
+        GLuint* cur = scratch;
+        if (l < SCOPE_GL_MAX_UNIFORM_LOCATIONS) {
+            cur = prog->values[l];
+            if (!(prog->known[l / 32] & (1u << (l % 32)))) {
+                if (is_int) { glGetUniformiv(prog->id, l, (GLint*) cur); } else { glGetUniformfv(prog->id, l, (GLfloat*) cur); }
+                _scope_gl_stat(queries, SCOPE_GL_STAT_UNIFORMS);
+                prog->known[l / 32] |= 1u << (l % 32);
+            }
+        } else { /* not shadowed */
+            if (top >= 0) { if (is_int) { glGetUniformiv(prog->id, l, (GLint*) cur); } else { glGetUniformfv(prog->id, l, (GLfloat*) cur); } _scope_gl_stat(queries, SCOPE_GL_STAT_UNIFORMS); }
+            *changed = 1;
+        }
+        if (top >= 0) { memcpy(&ctx->uniform_stack[top + e * comps], cur, comps * sizeof(GLuint)); }
+        if (memcmp(cur, src, comps * sizeof(GLuint)) != 0) { memcpy(cur, src, comps * sizeof(GLuint)); *changed = 1; }
+    }
+    *changed = _scope_gl_changed(*changed);
+    return top;
+}
+
+/* pops the values saved by _scope_gl_uniform_push() back into the store, returns them if they have to be uploaded */
+const void* _scope_gl_uniform_pop(GLint location, GLsizei count, int comps, GLint top) {
+    scope_gl_context_t* ctx = _scope_gl_ctx;
+    if (top < 0) { return NULL; }
+
+    scope_gl_program_t* prog = _scope_gl_program(_scope_gl_known(SCOPE_GL_STATE_PROGRAM | SCOPE_GL_STATE_UNIFORMS)->program);
+    const GLuint* saved = &ctx->uniform_stack[top];
+    ctx->uniform_top = top;
+
+    int changed = 0;
+    for (GLsizei e = 0; e < count; e++) {
+        GLint l = location + e;
+        if (l >= SCOPE_GL_MAX_UNIFORM_LOCATIONS) { changed = 1; continue; }
+        if (!(prog->known[l / 32] & (1u << (l % 32))) || memcmp(prog->values[l], &saved[e * comps], comps * sizeof(GLuint)) != 0) {
+            memcpy(prog->values[l], &saved[e * comps], comps * sizeof(GLuint));
+            prog->known[l / 32] |= 1u << (l % 32);
+            changed = 1;
+        }
+    }
+    return _scope_gl_changed(changed) ? saved : NULL;
+}
+#endif // SCOPE_GL_SHADOW_STATE
+
+#endif // SCOPE_GL_IMPLEMENTATION
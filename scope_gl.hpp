@@ -0,0 +1,216 @@
+/*
+** scope_gl.hpp : C++17 guards on top of scope_gl.h
+**
+** Same push/pop semantics and modes as the macros, but as RAII guards, so early return/break/throw inside the scope
+** restore the state as well and any number of guards can share a line:
+**
+**   {
+**       scope_gl::UseProgram                  program(shader);
+**       scope_gl::BindTexture<GL_TEXTURE_2D>  texture(tex);
+**       scope_gl::Enable<GL_BLEND>            blend;
+**       scope_gl::BlendFunc                   func(GL_ONE, GL_SRC_ALPHA);
+**       glDrawArrays(GL_TRIANGLES, 0, 6);
+**   }
+**
+** Targets, caps and their binding enums are template arguments resolved at compile time, so a restore mode guard is
+** exactly one glGet* plus the set and the restore call, an unset mode guard just the two calls. In shadow mode the
+** guards go through the same tracked setters as the macros and can be mixed with them freely.
+** Draws in lazy mode still need scope_glDrawArrays()/scope_glFlushState() from scope_gl.h.
+**
+** NOTE: the guards are not counted as scopes by SCOPE_GL_STATS and leave no SCOPE_GL_CHECK_ERRORS site, the gl*
+**       calls and queries of the tracked setters are counted as usual.
+*/
+
+#ifndef SCOPE_GL_HPP_
+#define SCOPE_GL_HPP_
+
+#include "scope_gl.h"
+
+#include <array>
+#include <type_traits>
+
+namespace scope_gl {
+namespace detail {
+
+#if defined(SCOPE_GL_SHADOW_STATE)
+inline constexpr bool shadow = true;
+#else
+inline constexpr bool shadow = false;
+#endif
+#if defined(SCOPE_GL_RESTORE_STATE)
+inline constexpr bool restore = true;
+#else
+inline constexpr bool restore = false;
+#endif
+
+/* the value to set, the old one when restoring and how to query/set/exchange it, per kind of state:
+**   value_type, tracked (exchange() exists), restore_only (there is no unset value), query(), set(), exchange(), unset() */
+template <class Op>
+class [[nodiscard]] guard {
+public:
+    using value_type = typename Op::value_type;
+
+    guard(const Op& op, const value_type& value) : op_(op) {
+        if constexpr (tracked) { old_ = op_.exchange(value); }
+        else {
+            if constexpr (keeps_old) { old_ = op_.query(); }
+            op_.set(value);
+        }
+    }
+    ~guard() {
+        if constexpr (tracked) { op_.exchange(keeps_old ? old_ : Op::unset()); }
+        else                   { op_.set(keeps_old ? old_ : Op::unset()); }
+    }
+    guard(const guard&)            = delete;
+    guard& operator=(const guard&) = delete;
+
+private:
+    static constexpr bool tracked   = shadow && Op::tracked;
+    static constexpr bool keeps_old = restore || Op::restore_only;
+    Op         op_;
+    value_type old_{};
+};
+
+template <GLenum Target> struct texture_binding;
+template <GLenum Target> struct buffer_binding;
+#define _SCOPE_GL_HPP_TEXTURE_BINDING(target, binding) template <> struct texture_binding<target> { static constexpr GLenum value = binding; };
+#define _SCOPE_GL_HPP_BUFFER_BINDING(target, binding)  template <> struct buffer_binding<target>  { static constexpr GLenum value = binding; };
+_SCOPE_GL_TEXTURE_TARGETS(_SCOPE_GL_HPP_TEXTURE_BINDING)
+_SCOPE_GL_BUFFER_TARGETS(_SCOPE_GL_HPP_BUFFER_BINDING)
+_SCOPE_GL_HPP_BUFFER_BINDING(GL_ELEMENT_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER_BINDING)
+#undef _SCOPE_GL_HPP_TEXTURE_BINDING
+#undef _SCOPE_GL_HPP_BUFFER_BINDING
+
+template <GLenum Target> struct framebuffer_binding { static constexpr GLenum value = GL_DRAW_FRAMEBUFFER_BINDING; };
+template <>              struct framebuffer_binding<GL_READ_FRAMEBUFFER> { static constexpr GLenum value = GL_READ_FRAMEBUFFER_BINDING; };
+
+inline GLuint get_uint(GLenum pname) { GLint v; glGetIntegerv(pname, &v); return (GLuint) v; }
+
+/* single GLuint/GLenum state, e.g. a binding */
+#if defined(SCOPE_GL_SHADOW_STATE)
+  #define _SCOPE_GL_HPP_EXCHANGE(call) call
+#else
+  #define _SCOPE_GL_HPP_EXCHANGE(call) 0
+#endif
+#define _SCOPE_GL_HPP_UINT_OP(name, type, query_call, set_call, exchange_call, unset_value)                        \
+    struct name {                                                                                                  \
+        using value_type = type;                                                                                   \
+        static constexpr bool tracked = true, restore_only = false;                                                \
+        static value_type query()                  { return (value_type) (query_call); }                           \
+        static void set(value_type v)              { set_call; }                                                   \
+        static value_type exchange(value_type v)   { (void) v; return (value_type) _SCOPE_GL_HPP_EXCHANGE(exchange_call); } \
+        static constexpr value_type unset()        { return unset_value; }                                         \
+    };
+
+_SCOPE_GL_HPP_UINT_OP(program_op,        GLuint, get_uint(GL_CURRENT_PROGRAM),      glUseProgram(v),                _scope_gl_use_program(v),           0)
+_SCOPE_GL_HPP_UINT_OP(vertex_array_op,   GLuint, get_uint(GL_VERTEX_ARRAY_BINDING), glBindVertexArray(v),           _scope_gl_bind_vertex_array(v),     0)
+_SCOPE_GL_HPP_UINT_OP(renderbuffer_op,   GLuint, get_uint(GL_RENDERBUFFER_BINDING), glBindRenderbuffer(GL_RENDERBUFFER, v), _scope_gl_bind_renderbuffer(GL_RENDERBUFFER, v), 0)
+_SCOPE_GL_HPP_UINT_OP(blend_equation_op, GLenum, get_uint(GL_BLEND_EQUATION_RGB),   glBlendEquation(v),             _scope_gl_blend_equation(v),        GL_FUNC_ADD)
+_SCOPE_GL_HPP_UINT_OP(cull_face_op,      GLenum, get_uint(GL_CULL_FACE_MODE),       glCullFace(v),                  _scope_gl_cull_face(v),             GL_BACK)
+_SCOPE_GL_HPP_UINT_OP(front_face_op,     GLenum, get_uint(GL_FRONT_FACE),           glFrontFace(v),                 _scope_gl_front_face(v),            GL_CCW)
+_SCOPE_GL_HPP_UINT_OP(active_texture_op, GLenum, get_uint(GL_ACTIVE_TEXTURE),       glActiveTexture(v),             GL_TEXTURE0 + _scope_gl_active_texture(v - GL_TEXTURE0), GL_TEXTURE0)
+
+template <GLenum Target> _SCOPE_GL_HPP_UINT_OP(texture_op,     GLuint, get_uint(texture_binding<Target>::value),     glBindTexture(Target, v),     _scope_gl_bind_texture(Target, v),     0)
+template <GLenum Target> _SCOPE_GL_HPP_UINT_OP(buffer_op,      GLuint, get_uint(buffer_binding<Target>::value),      glBindBuffer(Target, v),      _scope_gl_bind_buffer(Target, v),      0)
+template <GLenum Target> _SCOPE_GL_HPP_UINT_OP(framebuffer_op, GLuint, get_uint(framebuffer_binding<Target>::value), glBindFramebuffer(Target, v), _scope_gl_bind_framebuffer(Target, v), 0)
+#undef _SCOPE_GL_HPP_UINT_OP
+
+template <GLenum Cap, GLboolean Enable>
+struct cap_op {
+    using value_type = GLboolean;
+    static constexpr bool tracked = true, restore_only = false;
+    static value_type query()                { return glIsEnabled(Cap); }
+    static void set(value_type v)            { if (v) { glEnable(Cap); } else { glDisable(Cap); } }
+    static value_type exchange(value_type v) { (void) v; return (value_type) _SCOPE_GL_HPP_EXCHANGE(_scope_gl_enable(Cap, v)); }
+    static constexpr value_type unset()      { return !Enable; }
+};
+
+struct sampler_op {
+    using value_type = GLuint;
+    static constexpr bool tracked = true, restore_only = false;
+    GLuint unit;
+    value_type query() const                { return _scope_gl_query_unit(unit, GL_SAMPLER_BINDING); }
+    void set(value_type v) const            { glBindSampler(unit, v); }
+    value_type exchange(value_type v) const { (void) v; return (value_type) _SCOPE_GL_HPP_EXCHANGE(_scope_gl_bind_sampler(unit, v)); }
+    static constexpr value_type unset()     { return 0; }
+};
+
+/* rectangles and colors, the tracked setters hand back the old value through an out array */
+#if defined(SCOPE_GL_SHADOW_STATE)
+  #define _SCOPE_GL_HPP_EXCHANGE_OUT(call) call
+#else
+  #define _SCOPE_GL_HPP_EXCHANGE_OUT(call) ((void) 0)
+#endif
+#define _SCOPE_GL_HPP_ARRAY_OP(name, type, n, query_call, set_call, exchange_call, ...)                                        \
+    struct name {                                                                                                              \
+        using value_type = std::array<type, n>;                                                                                \
+        static constexpr bool tracked = true, restore_only = false;                                                            \
+        static value_type query()                        { value_type v; query_call; return v; }                             \
+        static void set(const value_type& v)             { set_call; }                                                        \
+        static value_type exchange(const value_type& v)  { value_type old{}; (void) v; _SCOPE_GL_HPP_EXCHANGE_OUT(exchange_call); return old; } \
+        static constexpr value_type unset()              { return value_type{ __VA_ARGS__ }; }                               \
+    };
+
+_SCOPE_GL_HPP_ARRAY_OP(viewport_op,    GLint,   4, glGetIntegerv(GL_VIEWPORT, v.data()),          glViewport(v[0], v[1], v[2], v[3]),   _scope_gl_viewport(v[0], v[1], v[2], v[3], old.data()),    0, 0, 0, 0)
+_SCOPE_GL_HPP_ARRAY_OP(scissor_op,     GLint,   4, glGetIntegerv(GL_SCISSOR_BOX, v.data()),       glScissor(v[0], v[1], v[2], v[3]),    _scope_gl_scissor(v[0], v[1], v[2], v[3], old.data()),     0, 0, 1000000000, 1000000000)
+_SCOPE_GL_HPP_ARRAY_OP(clear_color_op, GLfloat, 4, glGetFloatv(GL_COLOR_CLEAR_VALUE, v.data()),   glClearColor(v[0], v[1], v[2], v[3]), _scope_gl_clear_color(v[0], v[1], v[2], v[3], old.data()), 0, 0, 0, 0)
+_SCOPE_GL_HPP_ARRAY_OP(blend_func_op,  GLenum,  2, (v[0] = get_uint(GL_BLEND_SRC_RGB), v[1] = get_uint(GL_BLEND_DST_RGB)), glBlendFunc(v[0], v[1]), _scope_gl_blend_func(v[0], v[1], old.data()), 0, 0)
+#undef _SCOPE_GL_HPP_ARRAY_OP
+#undef _SCOPE_GL_HPP_EXCHANGE_OUT
+#undef _SCOPE_GL_HPP_EXCHANGE
+
+/* texture object state, not tracked and always restored like scope_glTex2DParameter, flushes the binding first (lazy mode) */
+template <GLenum Target, class T>
+struct tex_parameter_op {
+    static_assert(std::is_same_v<T, GLint> || std::is_same_v<T, GLfloat>, "glTexParameteri or glTexParameterf");
+    using value_type = T;
+    static constexpr bool tracked = false, restore_only = true;
+    GLenum pname;
+    value_type query() const {
+        value_type v;
+        _scope_gl_flush(SCOPE_GL_STATE_TEXTURES);
+        if constexpr (std::is_same_v<T, GLint>) { glGetTexParameteriv(Target, pname, &v); } else { glGetTexParameterfv(Target, pname, &v); }
+        return v;
+    }
+    void set(value_type v) const {
+        _scope_gl_flush(SCOPE_GL_STATE_TEXTURES);
+        if constexpr (std::is_same_v<T, GLint>) { glTexParameteri(Target, pname, v); } else { glTexParameterf(Target, pname, v); }
+    }
+    value_type exchange(value_type v) const { return v; }
+    static constexpr value_type unset()     { return 0; }
+};
+
+} // namespace detail
+
+/* guards, named like the gl* call they make */
+struct [[nodiscard]] UseProgram        : detail::guard<detail::program_op>        { explicit UseProgram(GLuint program)       : guard({}, program) {} };
+struct [[nodiscard]] BindVertexArray   : detail::guard<detail::vertex_array_op>   { explicit BindVertexArray(GLuint vao)      : guard({}, vao) {} };
+struct [[nodiscard]] BindRenderbuffer  : detail::guard<detail::renderbuffer_op>   { explicit BindRenderbuffer(GLuint rb)      : guard({}, rb) {} };
+struct [[nodiscard]] BlendEquation     : detail::guard<detail::blend_equation_op> { explicit BlendEquation(GLenum eq)         : guard({}, eq) {} };
+struct [[nodiscard]] CullFace          : detail::guard<detail::cull_face_op>      { explicit CullFace(GLenum mode)            : guard({}, mode) {} };
+struct [[nodiscard]] FrontFace         : detail::guard<detail::front_face_op>     { explicit FrontFace(GLenum orient)         : guard({}, orient) {} };
+struct [[nodiscard]] ActiveTexture     : detail::guard<detail::active_texture_op> { explicit ActiveTexture(GLenum texture)     : guard({}, texture) {} };
+struct [[nodiscard]] BindSampler       : detail::guard<detail::sampler_op>        { BindSampler(GLuint unit, GLuint sampler)  : guard({unit}, sampler) {} };
+struct [[nodiscard]] Viewport          : detail::guard<detail::viewport_op>       { Viewport(GLint x, GLint y, GLsizei w, GLsizei h)          : guard({}, {x, y, w, h}) {} };
+struct [[nodiscard]] Scissor           : detail::guard<detail::scissor_op>        { Scissor(GLint x, GLint y, GLsizei w, GLsizei h)           : guard({}, {x, y, w, h}) {} };
+struct [[nodiscard]] ClearColor        : detail::guard<detail::clear_color_op>    { ClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a)    : guard({}, {r, g, b, a}) {} };
+struct [[nodiscard]] BlendFunc         : detail::guard<detail::blend_func_op>     { BlendFunc(GLenum src, GLenum dst)                         : guard({}, {src, dst}) {} };
+
+template <GLenum Target>
+struct [[nodiscard]] BindTexture     : detail::guard<detail::texture_op<Target>>     { explicit BindTexture(GLuint texture)  : detail::guard<detail::texture_op<Target>>({}, texture) {} };
+template <GLenum Target>
+struct [[nodiscard]] BindBuffer      : detail::guard<detail::buffer_op<Target>>      { explicit BindBuffer(GLuint buffer)    : detail::guard<detail::buffer_op<Target>>({}, buffer) {} };
+template <GLenum Target>
+struct [[nodiscard]] BindFramebuffer : detail::guard<detail::framebuffer_op<Target>> { explicit BindFramebuffer(GLuint fbo)   : detail::guard<detail::framebuffer_op<Target>>({}, fbo) {} };
+template <GLenum Cap>
+struct [[nodiscard]] Enable          : detail::guard<detail::cap_op<Cap, GL_TRUE>>   { Enable()  : detail::guard<detail::cap_op<Cap, GL_TRUE>>({}, GL_TRUE) {} };
+template <GLenum Cap>
+struct [[nodiscard]] Disable         : detail::guard<detail::cap_op<Cap, GL_FALSE>>  { Disable() : detail::guard<detail::cap_op<Cap, GL_FALSE>>({}, GL_FALSE) {} };
+template <GLenum Target, class T = GLint>
+struct [[nodiscard]] TexParameter    : detail::guard<detail::tex_parameter_op<Target, T>> {
+    TexParameter(GLenum pname, T value) : detail::guard<detail::tex_parameter_op<Target, T>>({pname}, value) {}
+};
+
+} // namespace scope_gl
+
+#endif // SCOPE_GL_HPP_
@@ -0,0 +1,219 @@
+/* headless benchmark of the scopes on an EGL context without a window, built once per mode by bench.sh
+ *
+ *   ./bench_shadow [draws] [depth] [frames]
+ *
+ * NOTE: the gl* call counts come from SCOPE_GL_STATS, so the timings of every mode include its counters */
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define SCOPE_GL_STATS
+#define SCOPE_GL_IMPLEMENTATION
+#include "../scope_gl.h"
+
+#if defined(SCOPE_GL_LAZY_STATE)
+    #define TRACKING "lazy"
+#elif defined(SCOPE_GL_SHADOW_STATE)
+    #define TRACKING "shadow"
+#else
+    #define TRACKING "direct"
+#endif
+#ifdef SCOPE_GL_RESTORE_STATE
+    #define MODE_NAME TRACKING "+restore"
+#else
+    #define MODE_NAME TRACKING "+unset"
+#endif
+
+#define VERT_SOURCE "#version 330\nuniform mat4 m; uniform vec4 c; uniform float t; void main() { gl_Position = m * c * t; }"
+#define FRAG_SOURCE "#version 330\nout vec4 color; void main() { color = vec4(1); }"
+
+typedef struct bench_t {
+    GLuint programs[2];
+    GLuint textures[2];
+    GLuint vao;
+    int    draws, depth, frames;
+} bench_t;
+
+#ifdef SCOPE_GL_SHADOW_STATE
+static scope_gl_context_t scope_ctx;
+#endif
+#ifdef SCOPE_GL_LAZY_STATE
+static scope_gl_cmdbuf_t cmdbuf;
+static scope_gl_batch_t  batch;
+static double cmdbuf_memory[1 << 20]; /* NOTE: double for the alignment */
+#endif
+
+static void init_context(void) {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (!get_platform_display) { fprintf(stderr, "EGL_EXT_platform_base missing\n"); exit(-1); }
+    EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (!eglInitialize(display, NULL, NULL) || !eglBindAPI(EGL_OPENGL_API)) { fprintf(stderr, "Couldn't initialize EGL\n"); exit(-1); }
+
+    EGLint attribs[] = { EGL_CONTEXT_MAJOR_VERSION, 4, EGL_CONTEXT_MINOR_VERSION, 3,
+                         EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE };
+    EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attribs);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) { fprintf(stderr, "Couldn't create GL context\n"); exit(-1); }
+
+    /* surfaceless contexts have no default framebuffer, draws would fail without one */
+    GLuint fbo, rbo;
+    glGenFramebuffers(1, &fbo);
+    glGenRenderbuffers(1, &rbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, 16, 16);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rbo);
+    glViewport(0, 0, 16, 16);
+    glEnable(GL_RASTERIZER_DISCARD); /* only the cpu side is measured */
+}
+
+static GLuint create_program(void) {
+    const char* vert_source = VERT_SOURCE;
+    const char* frag_source = FRAG_SOURCE;
+    GLuint vert = glCreateShader(GL_VERTEX_SHADER);
+    GLuint frag = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(vert, 1, &vert_source, NULL); glCompileShader(vert);
+    glShaderSource(frag, 1, &frag_source, NULL); glCompileShader(frag);
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vert);
+    glAttachShader(program, frag);
+    glLinkProgram(program);
+    glDeleteShader(vert);
+    glDeleteShader(frag);
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) { fprintf(stderr, "Couldn't link program\n"); exit(-1); }
+    return program;
+}
+
+/* same state for every draw, depth scopes deep */
+static void nested(bench_t* b, int level) {
+    if (level == 0) { scope_glDrawArrays(GL_POINTS, 0, 1); return; }
+    switch (level % 5) {
+        case 0: scope_glUseProgram(b->programs[0])       { nested(b, level - 1); } break;
+        case 1: scope_glBindTexture2D(b->textures[0])    { nested(b, level - 1); } break;
+        case 2: scope_glEnable(GL_BLEND)                 { nested(b, level - 1); } break;
+        case 3: scope_glBlendFunc(GL_ONE, GL_SRC_ALPHA)  { nested(b, level - 1); } break;
+        case 4: scope_glEnable(GL_DEPTH_TEST)            { nested(b, level - 1); } break;
+    }
+}
+
+static void workload_nested(bench_t* b) {
+    for (int i = 0; i < b->draws; i++) { nested(b, b->depth); }
+}
+
+/* every draw in its own sibling scopes, with programs and textures alternating (not blended, so it can be sorted) */
+static void workload_siblings(bench_t* b) {
+    for (int i = 0; i < b->draws; i++) {
+        scope_glUseProgram(b->programs[i % 2])
+         scope_glBindTexture2D(b->textures[(i / 2) % 2])
+          scope_glEnable(GL_DEPTH_TEST)
+        {
+            scope_glDrawArrays(GL_POINTS, 0, 1);
+        }
+    }
+}
+
+/* three uniform scopes per draw, two of them with the same value every time */
+static void workload_uniforms(bench_t* b) {
+    static const GLfloat matrix[16] = { 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 };
+    static const GLfloat colors[4][4] = { {1,0,0,1}, {0,1,0,1}, {0,0,1,1}, {1,1,1,1} };
+    scope_glUseProgram(b->programs[0])
+    for (int i = 0; i < b->draws; i++) {
+        scope_glUniformMatrix4fv(matrix, "m")
+         scope_glUniform4fv(colors[i % 4], "c")
+          scope_glUniformfv(1.0f, "t")
+        {
+            scope_glDrawArrays(GL_POINTS, 0, 1);
+        }
+    }
+}
+
+#ifdef SCOPE_GL_LAZY_STATE
+static void workload_siblings_recorded(bench_t* b) {
+    scope_glRecord(&cmdbuf) { workload_siblings(b); }
+    scope_gl_cmdbuf_submit(&cmdbuf);
+}
+
+/* same state for every draw, issued as multi-draws */
+static void workload_batched(bench_t* b) {
+    scope_glUseProgram(b->programs[0])
+     scope_glBindTexture2D(b->textures[0])
+      scope_glEnable(GL_DEPTH_TEST)
+       scope_glDrawBatch(&batch)
+    {
+        for (int i = 0; i < b->draws; i++) { scope_glDrawArrays(GL_POINTS, 0, 1); }
+    }
+    scope_gl_batch_frame(&batch);
+}
+#endif
+
+static double now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static void run(bench_t* b, const char* name, void (*workload)(bench_t*)) {
+    scope_glBindVertexArray(b->vao) { workload(b); } /* warm up caches and the driver */
+    glFinish();
+
+    scope_gl_stats_reset();
+    double elapsed = 0;
+    for (int frame = 0; frame < b->frames; frame++) {
+        double start = now_ns();
+        scope_glBindVertexArray(b->vao) { workload(b); }
+        scope_glFlushState();
+        elapsed += now_ns() - start;
+        glFinish(); /* NOTE: not timed */
+    }
+    scope_gl_stats_t stats = scope_gl_stats_snapshot();
+
+    GLuint sets = 0, skipped = 0, queries = 0;
+    for (int k = 0; k < SCOPE_GL_STAT_COUNT; k++) { sets += stats.sets[k]; skipped += stats.skipped[k]; queries += stats.queries[k]; }
+    double draws = (double) b->draws * b->frames;
+    printf("%-16s %-20s %10.1f ns/draw %8.2f calls/draw %8.2f queries/draw %8.2f skipped/draw\n",
+           MODE_NAME, name, elapsed / draws, (sets + queries) / draws + 1.0, queries / draws, skipped / draws);
+
+    GLenum err = glGetError();
+    if (err != GL_NO_ERROR) { fprintf(stderr, "GL error 0x%x in %s\n", err, name); exit(-1); }
+}
+
+int main(int argc, char** argv) {
+    bench_t b = {0};
+    b.draws  = (argc > 1) ? atoi(argv[1]) : 1000;
+    b.depth  = (argc > 2) ? atoi(argv[2]) : 8;
+    b.frames = (argc > 3) ? atoi(argv[3]) : 100;
+
+    init_context();
+    b.programs[0] = create_program();
+    b.programs[1] = create_program();
+    glGenTextures(2, b.textures);
+    glGenVertexArrays(1, &b.vao);
+
+#ifdef SCOPE_GL_SHADOW_STATE
+    scope_gl_context_sync(&scope_ctx);
+    scope_gl_make_current(&scope_ctx);
+#endif
+#ifdef SCOPE_GL_LAZY_STATE
+    scope_gl_cmdbuf_init(&cmdbuf, cmdbuf_memory, sizeof(cmdbuf_memory));
+    scope_gl_batch_init(&batch, (GLsizeiptr) b.draws * 16);
+#endif
+
+    char nested_name[32];
+    snprintf(nested_name, sizeof(nested_name), "nested x%d", b.depth);
+    run(&b, nested_name,          workload_nested);
+    run(&b, "siblings",           workload_siblings);
+    run(&b, "uniforms",           workload_uniforms);
+#ifdef SCOPE_GL_LAZY_STATE
+    run(&b, "siblings recorded",  workload_siblings_recorded);
+    run(&b, "batched",            workload_batched);
+#endif
+    return 0;
+}
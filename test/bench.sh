@@ -0,0 +1,19 @@
+#!/bin/bash
+# build and run the headless benchmark for every mode: ./bench.sh [draws] [depth] [frames]
+set -e
+
+CC=${CC:-clang}
+modes=("unset"          ""
+       "restore"        "-DSCOPE_GL_RESTORE_STATE"
+       "shadow"         "-DSCOPE_GL_SHADOW_STATE"
+       "shadow_restore" "-DSCOPE_GL_SHADOW_STATE -DSCOPE_GL_RESTORE_STATE"
+       "lazy"           "-DSCOPE_GL_LAZY_STATE"
+       "lazy_restore"   "-DSCOPE_GL_LAZY_STATE -DSCOPE_GL_RESTORE_STATE")
+
+for ((i = 0; i < ${#modes[@]}; i += 2)); do
+    $CC -O2 ${modes[i+1]} bench.c -o ./bench_${modes[i]} -lEGL -lGL
+done
+
+for ((i = 0; i < ${#modes[@]}; i += 2)); do
+    ./bench_${modes[i]} "$@"
+done
@@ -1,13 +1,27 @@
 #include "common.h"
 #include "pch.h"
 
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
 #define SCOPE_GL_RESTORE_STATE
+#define SCOPE_GL_SHADOW_STATE
+#define SCOPE_GL_IMPLEMENTATION
 #include "../scope_gl.h"
 
 void GLAPIENTRY gl_debug_callback(GLenum source, GLenum type, GLuint id,
                                   GLenum severity, GLsizei length,
                                   const GLchar* message, const void* userParam)
 {
+#ifdef SCOPE_GL_CHECK_ERRORS
+    const scope_gl_site_t* site = scope_gl_error_site(); /* innermost scope, the callback is synchronous */
+    if (site) { fprintf(stderr, "%s:%d: ", site->file, site->line); }
+#endif
     fprintf(stderr, "%s\n", message);
 }
 
@@ -21,11 +35,25 @@ const char* fragment_shader_source =
       #include "shader.glsl"
     ;
 
+/* drawn with while the programs of SHADERS are still being built, small enough to not be noticed when linked right away */
+const char* placeholder_vertex_source = SHADER_STRINGIFY(
+    layout (location = 0) in vec3 aPos;
+    uniform mat4 orthoProjection;
+    uniform mat4 view_matrix;
+    void main() { gl_Position = orthoProjection * view_matrix * vec4(aPos, 1.0); }
+);
+const char* placeholder_fragment_source = SHADER_STRINGIFY(
+    out vec4 FragColor;
+    void main() { FragColor = vec4(0.5, 0.5, 0.5, 1.0); }
+);
+
 #define SHADERS(X) \
     X(0, vertex_shader_source, fragment_shader_source )
 
 /* contains all state of the program */
 typedef struct state_t {
+    scope_gl_context_t gl; // NOTE: lives here so the tracked state survives a hot reload
+    scope_gl_samplers_t samplers;
     GLuint VAO, VBO;
     GLuint tex_id;
 
@@ -35,6 +63,10 @@ typedef struct state_t {
         SHADER_COUNT
     };
     GLuint shaders[SHADER_COUNT];
+    unsigned long long shader_hashes[SHADER_COUNT]; // of the sources the programs were linked from
+    GLuint building[SHADER_COUNT];                  // linking in the background, replaces shaders[] once done
+    unsigned long long building_hashes[SHADER_COUNT];
+    GLuint placeholder;
     int current_shader;
 
     float cam_x, cam_y;
@@ -120,20 +152,11 @@ const vertex_t vertices[] = {
      }
 };
 
-/* helper function */
+/* helper function, the status is only checked once the program is linked (see finish_shader_program), so compiles overlap */
 GLuint compile_shader(GLenum type, const char* source) {
     GLuint shader = glCreateShader(type);
     glShaderSource(shader, 1, &source, NULL);
     glCompileShader(shader);
-
-    GLint success;
-    GLchar infoLog[512];
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(shader, 512, NULL, infoLog);
-        fprintf(stderr, "Shader Compilation failed: %s\n", infoLog);
-        return 0;
-    }
     return shader;
 }
 
@@ -178,43 +201,286 @@ GLuint update_state(float cam_pos_x, float cam_pos_y, float zoom) {
     return success;
 }
 
-GLuint create_shader_program(const char* vertex_src, const char* frag_src) {
+/* compiles and links without waiting for either, with KHR_parallel_shader_compile the driver builds in the background */
+GLuint submit_shader_program(const char* vertex_src, const char* frag_src) {
     GLuint vertex_shader   = compile_shader(GL_VERTEX_SHADER, vertex_src);
     GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, frag_src);
 
-    if (!vertex_shader)   { return 0; }
-    if (!fragment_shader) { return 0; }
-
     GLuint shader_program = glCreateProgram();
     glAttachShader(shader_program, vertex_shader);
     glAttachShader(shader_program, fragment_shader);
+    glProgramParameteri(shader_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE); /* for the program cache */
     glLinkProgram(shader_program);
 
+    /* NOTE: only flagged, they stay attached until the program is finished for the compile errors */
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    return shader_program;
+}
+
+/* without KHR_parallel_shader_compile every program counts as done, finishing it waits for the driver */
+int shader_program_done(GLuint shader_program) {
+    GLint done = GL_TRUE;
+    if (GLEW_KHR_parallel_shader_compile) { glGetProgramiv(shader_program, GL_COMPLETION_STATUS_KHR, &done); }
+    return done;
+}
+
+/* checks a submitted program, 0 (and the program deleted) if it failed */
+GLuint finish_shader_program(GLuint shader_program) {
+    GLuint shaders[2];
+    GLsizei shader_count = 0;
+    glGetAttachedShaders(shader_program, 2, &shader_count, shaders);
+
     GLint success;
     GLchar infoLog[512];
     glGetProgramiv(shader_program, GL_LINK_STATUS, &success);
     if (!success) {
+        for (GLsizei i = 0; i < shader_count; i++) {
+            glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &success);
+            if (success) { continue; }
+            glGetShaderInfoLog(shaders[i], 512, NULL, infoLog);
+            fprintf(stderr, "Shader Compilation failed: %s\n", infoLog);
+        }
         glGetProgramInfoLog(shader_program, 512, NULL, infoLog);
         fprintf(stderr, "ERROR::PROGRAM::LINKING_FAILED\n%s\n", infoLog);
-        exit(EXIT_FAILURE);
+        glDeleteProgram(shader_program);
+        return 0;
     }
 
-    glDeleteShader(vertex_shader);
-    glDeleteShader(fragment_shader);
-
+    for (GLsizei i = 0; i < shader_count; i++) { glDetachShader(shader_program, shaders[i]); } /* deletes them */
     return shader_program;
 }
 
+GLuint create_shader_program(const char* vertex_src, const char* frag_src) {
+    return finish_shader_program(submit_shader_program(vertex_src, frag_src));
+}
+
+/* FNV-1a */
+#define HASH_SEED 14695981039346656037ull
+unsigned long long hash_bytes(unsigned long long hash, const void* data, size_t size) {
+    for (size_t i = 0; i < size; i++) { hash = (hash ^ ((const unsigned char*) data)[i]) * 1099511628211ull; }
+    return hash;
+}
+
+/* tells which SHADERS entries changed since the last reload (with the terminators, so moving code between the stages counts) */
+unsigned long long hash_sources(const char* vert_src, const char* frag_src) {
+    unsigned long long hash = hash_bytes(HASH_SEED, vert_src, strlen(vert_src) + 1);
+    return hash_bytes(hash, frag_src, strlen(frag_src) + 1);
+}
+
+/* on-disk cache of linked program binaries (glProgramBinary), so a cold start skips compiling and linking from source.
+ * One file of records that are appended as programs get linked and that is mapped into memory while the SHADERS table
+ * is loaded. Records are keyed by the hash of the sources and of the driver strings, the newest record of a key wins.
+ * A binary the driver rejects anyway is linked from source and appended again. -DNO_PROGRAM_CACHE turns it off. */
+#ifndef NO_PROGRAM_CACHE
+#define PROGRAM_CACHE_FILE "./programs.cache"
+#endif
+#define PROGRAM_CACHE_MAGIC "PRGCACH1" // 8 bytes in front of the records, a file without it is started over
+
+typedef struct program_cache_record_t {
+    unsigned long long key;
+    GLenum             format;
+    GLuint             length; // of the binary following the record, padded to 8 bytes
+} program_cache_record_t;
+
+typedef struct program_cache_t {
+    const unsigned char* memory; // mapping of the file, NULL if there is none yet
+    size_t               size;
+    unsigned long long   driver_hash;
+    int                  enabled; // driver has at least one binary format
+    int                  valid;   // file exists and starts with PROGRAM_CACHE_MAGIC
+#ifdef _WIN32
+    HANDLE               file, mapping;
+#endif
+} program_cache_t;
+
+void program_cache_unmap(program_cache_t* cache) {
+#ifdef _WIN32
+    if (cache->memory)  { UnmapViewOfFile(cache->memory); }
+    if (cache->mapping) { CloseHandle(cache->mapping); }
+    if (cache->file)    { CloseHandle(cache->file); }
+    cache->file = cache->mapping = NULL;
+#else
+    if (cache->memory)  { munmap((void*) cache->memory, cache->size); }
+#endif
+    cache->memory = NULL;
+    cache->size   = 0;
+}
+
+void program_cache_close(program_cache_t* cache) {
+    program_cache_unmap(cache);
+    memset(cache, 0, sizeof(*cache));
+}
+
+void program_cache_open(program_cache_t* cache) {
+    memset(cache, 0, sizeof(*cache));
+#ifdef PROGRAM_CACHE_FILE
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0) { return; }
+    cache->enabled = 1;
+
+    /* NOTE: binaries are only valid for the driver that produced them */
+    const GLenum driver_strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    cache->driver_hash = HASH_SEED;
+    for (int i = 0; i < 3; i++) {
+        const char* str = (const char*) glGetString(driver_strings[i]);
+        if (str) { cache->driver_hash = hash_bytes(cache->driver_hash, str, strlen(str) + 1); }
+    }
+
+#ifdef _WIN32
+    cache->file = CreateFileA(PROGRAM_CACHE_FILE, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (cache->file == INVALID_HANDLE_VALUE) { cache->file = NULL; return; }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(cache->file, &size) || size.QuadPart == 0) { return; }
+    cache->mapping = CreateFileMappingA(cache->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (cache->mapping) {
+        cache->memory = (const unsigned char*) MapViewOfFile(cache->mapping, FILE_MAP_READ, 0, 0, 0);
+        cache->size   = cache->memory ? (size_t) size.QuadPart : 0;
+    }
+#else
+    int fd = open(PROGRAM_CACHE_FILE, O_RDONLY);
+    if (fd < 0) { return; }
+    struct stat attr;
+    if (fstat(fd, &attr) == 0 && attr.st_size > 0) {
+        void* memory = mmap(NULL, (size_t) attr.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (memory != MAP_FAILED) { cache->memory = (const unsigned char*) memory; cache->size = (size_t) attr.st_size; }
+    }
+    close(fd); // NOTE: the mapping stays valid
+#endif
+    cache->valid = (cache->size >= 8 && memcmp(cache->memory, PROGRAM_CACHE_MAGIC, 8) == 0);
+    if (!cache->valid) { program_cache_unmap(cache); } // NOTE: rewritten on the first store, Windows can't truncate a mapped file
+#endif
+}
+
+/* newest record of key, a truncated record at the end (e.g. the program was killed while appending) is ignored */
+const program_cache_record_t* program_cache_find(const program_cache_t* cache, unsigned long long key) {
+    const program_cache_record_t* found = NULL;
+    if (!cache->valid) { return NULL; }
+    size_t at = 8;
+    while (at + sizeof(program_cache_record_t) <= cache->size) {
+        const program_cache_record_t* record = (const program_cache_record_t*) (cache->memory + at);
+        size_t next = at + sizeof(*record) + ((size_t) record->length + 7) / 8 * 8;
+        if (next > cache->size) { break; }
+        if (record->key == key) { found = record; }
+        at = next;
+    }
+    return found;
+}
+
+unsigned long long program_cache_key(const program_cache_t* cache, unsigned long long source_hash) {
+    return hash_bytes(cache->driver_hash, &source_hash, sizeof(source_hash));
+}
+
+/* NOTE: appended behind the mapping, which only covers the records that were there on open */
+void program_cache_store(program_cache_t* cache, unsigned long long source_hash, GLuint program) {
+#ifdef PROGRAM_CACHE_FILE
+    if (!cache->enabled) { return; }
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) { return; }
+
+    size_t size = sizeof(program_cache_record_t) + ((size_t) length + 7) / 8 * 8;
+    program_cache_record_t* record = (program_cache_record_t*) calloc(1, size);
+    if (!record) { return; }
+    record->key    = program_cache_key(cache, source_hash);
+    record->length = (GLuint) length;
+    glGetProgramBinary(program, length, NULL, &record->format, record + 1);
+
+    FILE* file = fopen(PROGRAM_CACHE_FILE, cache->valid ? "ab" : "wb");
+    if (file) {
+        if (!cache->valid) { fwrite(PROGRAM_CACHE_MAGIC, 8, 1, file); cache->valid = 1; }
+        fwrite(record, size, 1, file);
+        fclose(file);
+    }
+    free(record);
+#endif
+}
+
+/* 0 if there is no binary for the sources or the driver rejects it */
+GLuint program_cache_load(const program_cache_t* cache, unsigned long long source_hash) {
+    if (!cache->enabled) { return 0; }
+    const program_cache_record_t* record = program_cache_find(cache, program_cache_key(cache, source_hash));
+    if (!record) { return 0; }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, record->format, record + 1, (GLsizei) record->length);
+    GLint success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (success) { return program; }
+    glDeleteProgram(program); // rejected, e.g. a driver update that kept its version string
+    return 0;
+}
+
+void swap_shader_program(state_t* state, int idx, GLuint program, unsigned long long hash) {
+    GLuint old = state->shaders[idx];
+    if (old && old != program && old != state->placeholder) {
+        scope_gl_invalidate_program(old);
+        glDeleteProgram(old);
+    }
+    scope_gl_invalidate_program(program); /* NOTE: the id can be the one of a program deleted earlier */
+    state->shaders[idx]       = program;
+    state->shader_hashes[idx] = hash;
+}
+
+/* rebuilds a program only if its sources changed. A cached binary is used right away, otherwise the program is linked
+ * in the background (see poll_shader_builds) and until then the old one is drawn with, on the first load the placeholder */
+int reload_shader(state_t* state, program_cache_t* cache, int idx, const char* vert_src, const char* frag_src) {
+    unsigned long long hash = hash_sources(vert_src, frag_src);
+    if (state->shaders[idx] && state->shader_hashes[idx] == hash) { return 0; }
+    if (state->building[idx]) {
+        if (state->building_hashes[idx] == hash) { return 0; }
+        GLuint stale = state->building[idx]; // of sources that changed again in the meantime
+        scope_gl_program_ready(stale);
+        if (state->shaders[idx] == stale) { state->shaders[idx] = 0; }
+        glDeleteProgram(stale);
+        state->building[idx] = 0;
+    }
+
+    GLuint program = program_cache_load(cache, hash);
+    if (program) { swap_shader_program(state, idx, program, hash); return 1; }
+
+    program = submit_shader_program(vert_src, frag_src);
+    state->building[idx]        = program;
+    state->building_hashes[idx] = hash;
+    scope_gl_program_building(program, state->placeholder);
+    if (!state->shaders[idx]) { state->shaders[idx] = program; } // the scopes bind the placeholder instead until it is done
+    return 1;
+}
+
+/* once per frame: programs that finished linking replace the ones drawn with so far, the ones that failed are dropped
+ * (the old program stays, the build is retried on the next reload) */
+void poll_shader_builds(state_t* state) {
+    program_cache_t cache;
+    int cache_open = 0;
+    for (int idx = 0; idx < SHADER_COUNT; idx++) {
+        GLuint program = state->building[idx];
+        if (!program || !shader_program_done(program)) { continue; }
+
+        state->building[idx] = 0;
+        scope_gl_program_ready(program);
+        if (state->shaders[idx] == program) { state->shaders[idx] = state->placeholder; }
+        if (!finish_shader_program(program)) { continue; }
+
+        if (!cache_open) { program_cache_open(&cache); cache_open = 1; }
+        program_cache_store(&cache, state->building_hashes[idx], program);
+        swap_shader_program(state, idx, program, state->building_hashes[idx]);
+    }
+    if (cache_open) { program_cache_close(&cache); }
+}
+
 EXPORT void render(state_t* state) {
+    poll_shader_builds(state);
+
     scope_glUseProgram(state->shaders[state->current_shader])
      scope_glBindVertexArray(state->VAO)
       scope_glBindTexture2D(state->tex_id)
-       scope_glTex2DParameter(i,GL_TEXTURE_MIN_FILTER,GL_NEAREST)
-        scope_glTex2DParameter(i,GL_TEXTURE_MAG_FILTER,GL_NEAREST)
-         scope_glEnable(GL_BLEND)
-          scope_glBlendFunc(GL_ONE, GL_SRC_ALPHA)
-           scope_glViewport(0,0, SCREEN_WIDTH, SCREEN_HEIGHT)  // NOTE hardcoded
-            scope_glClearColor(0.1f, 0.2f, 0.1f, 0.2f)
+       scope_glSampler(0, GL_TEXTURE_MIN_FILTER, GL_NEAREST, GL_TEXTURE_MAG_FILTER, GL_NEAREST)
+        scope_glEnable(GL_BLEND)
+         scope_glBlendFunc(GL_ONE, GL_SRC_ALPHA)
+          scope_glViewport(0,0, SCREEN_WIDTH, SCREEN_HEIGHT)  // NOTE hardcoded
+           scope_glClearColor(0.1f, 0.2f, 0.1f, 0.2f)
     {
         glClear(GL_COLOR_BUFFER_BIT);
 
@@ -228,13 +494,30 @@ EXPORT void render(state_t* state) {
     }
 }
 
-int init_renderer(state_t* state) {
+/* every load of the code: the GL context and everything in state_t survive, but function pointers, the debug callback
+ * and the current scope_gl context/sampler cache (thread locals) live in the code that was just replaced */
+int load_gl_functions(state_t* state) {
     // Initialize GLEW
     glewExperimental = GL_TRUE;
     if (glewInit() != GLEW_OK) { fprintf(stderr, "Failed to initialize GLEW\n"); return -1; }
 
     glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
     glDebugMessageCallback(gl_debug_callback, NULL);
+    if (GLEW_KHR_parallel_shader_compile) { glMaxShaderCompilerThreadsKHR(0xFFFFFFFF); } // as many as the driver likes
+
+    scope_gl_make_current(&state->gl);
+    scope_gl_samplers_make_current(&state->samplers);
+    scope_gl_forget_uniform_names(); /* NOTE: cached by the address of the name, the old string literals are gone */
+    return 0;
+}
+
+/* first load only, the objects are kept across reloads */
+int init_renderer(state_t* state) {
+    /* read the tracked state once, all scopes after this are served from the shadow copy */
+    scope_gl_context_sync(&state->gl);
+    scope_gl_samplers_init(&state->samplers);
+
+    state->placeholder = create_shader_program(placeholder_vertex_source, placeholder_fragment_source);
 
     /* generate and bind vertex array object and vertex buffer object */
     glGenVertexArrays(1, &state->VAO);
@@ -290,23 +573,38 @@ void generate_texture_and_upload(state_t* state) {
 }
 
 EXPORT int on_reload(state_t* state) {
+    Uint64 start = SDL_GetPerformanceCounter();
+
     // check OpenGL error
     GLenum err;
     while ((err = glGetError()) != GL_NO_ERROR) {
         printf("OpenGL Error:%s\n", glewGetErrorString(err));
     }
 
-    init_renderer(state); // NOTE: should everything in this function be called on reload?
+    if (load_gl_functions(state) != 0) { return 0; }
+
+    int first_load = (state->VAO == 0);
+    if (first_load) {
+        init_renderer(state);
+        generate_texture_and_upload(state);
+    }
 
-    #define CREATE_SHADER(idx,vert_src,frag_src) state->shaders[idx] = create_shader_program(vert_src, frag_src);
-    SHADERS(CREATE_SHADER)
+    int rebuilt = 0;
+    program_cache_t cache;
+    program_cache_open(&cache);
+    #define RELOAD_SHADER(idx,vert_src,frag_src) rebuilt += reload_shader(state, &cache, idx, vert_src, frag_src);
+    SHADERS(RELOAD_SHADER)
+    program_cache_close(&cache);
 
-    generate_texture_and_upload(state);
+    if (!first_load) {
+        double ms = (double) (SDL_GetPerformanceCounter() - start) * 1000.0 / (double) SDL_GetPerformanceFrequency();
+        printf("Reloaded in %.2f ms, %d of %d shaders changed\n", ms, rebuilt, SHADER_COUNT);
+    }
     return 1;
 }
 
 EXPORT int on_load(state_t** state) {
-    (*state) = malloc(sizeof(state_t));
+    (*state) = calloc(1, sizeof(state_t));
 
     on_reload(*state);
 
@@ -0,0 +1,41 @@
+/* compile check of scope_gl.hpp: every guard once, built per mode by guards.sh. Nothing is run, so no context needed
+ *
+ * NOTE: the implementation is included as well, so its C++ build is checked too */
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#define SCOPE_GL_IMPLEMENTATION
+#include "../scope_gl.hpp"
+
+#define TEXTURE_GUARD(target, binding) { scope_gl::BindTexture<target> guard(texture); }
+#define BUFFER_GUARD(target, binding)  { scope_gl::BindBuffer<target>  guard(buffer); }
+
+void guards(GLuint program, GLuint vao, GLuint texture, GLuint buffer, GLuint fbo, GLuint renderbuffer, GLuint sampler) {
+    scope_gl::UseProgram                         use_program(program);
+    scope_gl::BindVertexArray                    vertex_array(vao);
+    scope_gl::BindRenderbuffer                   bind_renderbuffer(renderbuffer);
+    scope_gl::BlendEquation                      blend_equation(GL_FUNC_ADD);
+    scope_gl::CullFace                           cull_face(GL_FRONT);
+    scope_gl::FrontFace                          front_face(GL_CW);
+    scope_gl::ActiveTexture                      active_texture(GL_TEXTURE1);
+    scope_gl::BindSampler                        bind_sampler(1, sampler);
+    scope_gl::Viewport                           viewport(0, 0, 16, 16);
+    scope_gl::Scissor                            scissor(0, 0, 8, 8);
+    scope_gl::ClearColor                         clear_color(0, 0, 0, 1);
+    scope_gl::BlendFunc                          blend_func(GL_ONE, GL_SRC_ALPHA);
+    scope_gl::BindFramebuffer<GL_FRAMEBUFFER>      framebuffer(fbo);
+    scope_gl::BindFramebuffer<GL_DRAW_FRAMEBUFFER> draw_framebuffer(fbo);
+    scope_gl::BindFramebuffer<GL_READ_FRAMEBUFFER> read_framebuffer(fbo);
+    scope_gl::Enable<GL_BLEND>                   blend;
+    scope_gl::Disable<GL_DEPTH_TEST>             depth_test;
+    scope_gl::TexParameter<GL_TEXTURE_2D>        min_filter(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    scope_gl::TexParameter<GL_TEXTURE_2D, GLfloat> lod_bias(GL_TEXTURE_LOD_BIAS, 0.5f);
+    { /* the edit has to reach the texture bound by the guard before it, lazy mode flushes in between */
+        scope_gl::BindTexture<GL_TEXTURE_2D>  bind_texture(texture);
+        scope_gl::TexParameter<GL_TEXTURE_2D> wrap_s(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    }
+    _SCOPE_GL_TEXTURE_TARGETS(TEXTURE_GUARD)
+    _SCOPE_GL_BUFFER_TARGETS(BUFFER_GUARD)
+    BUFFER_GUARD(GL_ELEMENT_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER_BINDING)
+}
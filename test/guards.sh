@@ -0,0 +1,18 @@
+#!/bin/bash
+# compile every C++ guard of scope_gl.hpp for every mode: ./guards.sh
+set -e
+
+CXX=${CXX:-clang++}
+modes=("unset"          ""
+       "restore"        "-DSCOPE_GL_RESTORE_STATE"
+       "shadow"         "-DSCOPE_GL_SHADOW_STATE"
+       "shadow_restore" "-DSCOPE_GL_SHADOW_STATE -DSCOPE_GL_RESTORE_STATE"
+       "lazy"           "-DSCOPE_GL_LAZY_STATE"
+       "lazy_restore"   "-DSCOPE_GL_LAZY_STATE -DSCOPE_GL_RESTORE_STATE"
+       "check_errors"   "-DSCOPE_GL_CHECK_ERRORS -DSCOPE_GL_RESTORE_STATE"
+       "capture"        "-DSCOPE_GL_CAPTURE -DSCOPE_GL_RESTORE_STATE")
+
+for ((i = 0; i < ${#modes[@]}; i += 2)); do
+    $CXX -std=c++17 -Wall -Wextra ${modes[i+1]} -c guards.cpp -o /dev/null
+    echo "${modes[i]}: ok"
+done
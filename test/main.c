@@ -1,11 +1,13 @@
 #include "common.h"
 #include "pch.h"
+#include <string.h>
 
 /* forward declarations */
 typedef struct state_t state_t;
 
 /* HOT RELOAD */
-#define DLL_FILENAME "./code.dll"
+#define DLL_NAME     "code.dll"
+#define DLL_FILENAME "./" DLL_NAME
 #define DLL_TABLE(X)               \
     X(int,  on_load,   state_t**)  \
     X(void, render,    state_t*)   \
@@ -18,57 +20,184 @@ typedef struct dll_t {
     DLL_TABLE(DLL_FUNCTIONS)
 
     void* handle;
-    time_t last_mod;
     const char* file;
 } dll_t;
 static dll_t dll;
 
 #ifdef _WIN32
   #include <windows.h>
-  #define DLL_FILE_TMP DLL_FILENAME ".tmp"
-  #define USE_TMP_DLL_IF_WIN32(sleeptime)   \
-     Sleep(sleeptime); CopyFile(DLL_FILENAME, DLL_FILE_TMP, 0)
 #else
-  #define USE_TMP_DLL_IF_WIN32(sleeptime)
-  #define DLL_FILE_TMP DLL_FILENAME // no tmp dll needed
+  #include <poll.h>
+  #include <sys/inotify.h>
+  #include <unistd.h>
 #endif
 
+/* the dll is loaded from a copy, so the compiler can overwrite it (Windows locks loaded dlls) and a new image can be
+ * loaded while the old one still runs (the loader would hand back the old image for the same file). The copies alternate */
+static const char* dll_copies[2] = { DLL_FILENAME ".0.tmp", DLL_FILENAME ".1.tmp" };
+
+/* set by the watcher thread once the next dll is loaded, cleared by the render thread after swapping it in */
+static SDL_atomic_t dll_ready;
+static dll_t        dll_next;
+
+#define DLL_DEBOUNCE_MS 200 /* without writes to the dll before it is loaded */
+
 //static state_t state; // NOTE all program state lives in data section for this example
 static state_t* state; // allocated by dll
 static SDL_GLContext context;
 static SDL_Window* window;
 
-int platform_load_code(dll_t* dll)
+/* fails if the file changed during the copy, i.e. the compiler is still writing it */
+int copy_file(const char* src, const char* dst)
 {
-    dll->file = DLL_FILE_TMP;
+    struct stat before, after;
+    if (stat(src, &before) != 0 || before.st_size == 0) { return 0; }
 
-    if (dll->handle) /* unload old dll */
-    {
-        #define SET_TO_NULL(ret, func, ...) dll->func = NULL;
-        DLL_TABLE(SET_TO_NULL)
+    remove(dst); /* NOTE: a new file, an old image that is still mapped keeps its pages */
+    FILE* in  = fopen(src, "rb");
+    FILE* out = in ? fopen(dst, "wb") : NULL;
+    char buffer[1 << 16];
+    size_t size, total = 0;
+    while (out && (size = fread(buffer, 1, sizeof(buffer), in)) > 0) { total += fwrite(buffer, 1, size, out); }
+    if (in)  { fclose(in); }
+    if (out) { fclose(out); }
 
-        SDL_UnloadObject(dll->handle);
-        dll->handle = NULL;
+    return out && (stat(src, &after) == 0) && (total == (size_t) before.st_size) &&
+           (after.st_size == before.st_size) && (after.st_mtime == before.st_mtime);
+}
 
-        USE_TMP_DLL_IF_WIN32(500); /* NOTE: Linux can load new dll directly */
-    }
+/* loads a copy of the dll and looks up all functions, also works off the render thread */
+int platform_load_code(dll_t* dll, const char* file)
+{
+    memset(dll, 0, sizeof(*dll));
+    if (!copy_file(DLL_FILENAME, file)) { return 0; }
 
+    dll->file   = file;
     dll->handle = SDL_LoadObject(dll->file);
-    if (dll->handle == NULL) { printf("Opening DLL failed. Trying again...\n"); }
-    while (dll->handle == NULL) /* NOTE keep trying to load dll */
-    {
-        dll->handle = SDL_LoadObject(dll->file);
-    }
+    if (dll->handle == NULL) { return 0; }
 
     /* load all dll functions (and print out any not found) */
     #define LOAD_FUNCTION(ret, func, ...) \
         dll->func = (ret (*)(__VA_ARGS__)) SDL_LoadFunction(dll->handle, #func); \
-        if (!dll->func) { printf("Error finding function: %s\n", #func); return 0; }
+        if (!dll->func) { printf("Error finding function: %s\n", #func); SDL_UnloadObject(dll->handle); dll->handle = NULL; return 0; }
     DLL_TABLE(LOAD_FUNCTION)
 
     return 1;
 }
 
+/* directory watch: 1 if the dll was written, 2 for other files, 0 on timeout (timeout_ms -1 waits forever), -1 on errors */
+#ifdef _WIN32
+typedef struct dll_watch_t {
+    HANDLE     dir;
+    OVERLAPPED overlapped;
+    DWORD      buffer[1024]; // FILE_NOTIFY_INFORMATION records, DWORD aligned
+    int        pending;      // a ReadDirectoryChangesW is in flight
+} dll_watch_t;
+
+int watch_init(dll_watch_t* watch)
+{
+    memset(watch, 0, sizeof(*watch));
+    watch->dir = CreateFileA(".", FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                             OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    watch->overlapped.hEvent = CreateEventA(NULL, FALSE, FALSE, NULL);
+    return (watch->dir != INVALID_HANDLE_VALUE) && watch->overlapped.hEvent;
+}
+
+int watch_wait(dll_watch_t* watch, int timeout_ms)
+{
+    if (!watch->pending)
+    {
+        const DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_FILE_NAME;
+        if (!ReadDirectoryChangesW(watch->dir, watch->buffer, sizeof(watch->buffer), FALSE, filter, NULL, &watch->overlapped, NULL)) { return -1; }
+        watch->pending = 1;
+    }
+    if (WaitForSingleObject(watch->overlapped.hEvent, (timeout_ms < 0) ? INFINITE : (DWORD) timeout_ms) != WAIT_OBJECT_0) { return 0; }
+    watch->pending = 0;
+
+    DWORD size;
+    if (!GetOverlappedResult(watch->dir, &watch->overlapped, &size, FALSE)) { return -1; }
+    if (size == 0) { return 1; } // NOTE: more changes than the buffer holds, the dll may be one of them
+
+    const WCHAR name[] = L"" DLL_NAME;
+    FILE_NOTIFY_INFORMATION* info = (FILE_NOTIFY_INFORMATION*) watch->buffer;
+    for (;;)
+    {
+        if (info->FileNameLength == sizeof(name) - sizeof(WCHAR) && memcmp(info->FileName, name, info->FileNameLength) == 0) { return 1; }
+        if (info->NextEntryOffset == 0) { return 2; }
+        info = (FILE_NOTIFY_INFORMATION*) ((char*) info + info->NextEntryOffset);
+    }
+}
+#else
+typedef struct dll_watch_t { int fd; } dll_watch_t;
+
+int watch_init(dll_watch_t* watch)
+{
+    /* NOTE: the directory, compilers often write a new file and rename it over the old one */
+    watch->fd = inotify_init1(IN_CLOEXEC);
+    return (watch->fd >= 0) && (inotify_add_watch(watch->fd, ".", IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO) >= 0);
+}
+
+int watch_wait(dll_watch_t* watch, int timeout_ms)
+{
+    struct pollfd events = { watch->fd, POLLIN, 0 };
+    int ready = poll(&events, 1, timeout_ms);
+    if (ready <= 0) { return ready; }
+
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t size = read(watch->fd, buffer, sizeof(buffer));
+    if (size <= 0) { return -1; }
+
+    int changed = 2;
+    for (char* at = buffer; at < buffer + size; at += sizeof(struct inotify_event) + ((struct inotify_event*) at)->len)
+    {
+        struct inotify_event* event = (struct inotify_event*) at;
+        if (event->len && strcmp(event->name, DLL_NAME) == 0) { changed = 1; }
+    }
+    return changed;
+}
+#endif
+
+/* 1 once the dll was written, 0 if it wasn't within timeout_ms (-1 waits forever), -1 on errors */
+int wait_for_dll_write(dll_watch_t* watch, int timeout_ms)
+{
+    Uint64 deadline = SDL_GetTicks64() + (Uint64) timeout_ms;
+    for (;;)
+    {
+        int wait = timeout_ms;
+        if (timeout_ms >= 0) { Uint64 now = SDL_GetTicks64(); wait = (now >= deadline) ? 0 : (int) (deadline - now); }
+        int event = watch_wait(watch, wait);
+        if (event != 2) { return event; }
+    }
+}
+
+/* watcher thread: debounces the writes of a rebuild and loads the new dll, the render loop only swaps the function table */
+int watch_dll(void* data)
+{
+    dll_watch_t watch;
+    if (!watch_init(&watch)) { printf("Couldn't watch %s, hot reload is off\n", DLL_FILENAME); return 0; }
+
+    int copy = 1; // the first load used copy 0
+    while (wait_for_dll_write(&watch, -1) == 1)
+    {
+        printf("Attempting code hot reload...\n");
+
+        /* NOTE: an image that's still incomplete (or locked, e.g. by a virus scanner) is retried a few times */
+        int loaded = 0;
+        for (int attempt = 0; (attempt < 10) && !loaded; attempt++)
+        {
+            while (wait_for_dll_write(&watch, DLL_DEBOUNCE_MS) == 1) {}
+            loaded = platform_load_code(&dll_next, dll_copies[copy]);
+        }
+        if (!loaded) { printf("Loading %s failed, waiting for the next build\n", DLL_FILENAME); continue; }
+
+        SDL_AtomicSet(&dll_ready, 1);
+        while (SDL_AtomicGet(&dll_ready)) { SDL_Delay(1); } // about a frame, until the render thread took it
+        copy ^= 1;
+    }
+    printf("Watching %s failed, hot reload is off\n", DLL_FILENAME);
+    return 0;
+}
+
 int main(int argc, char* args[])
 {
     /* init */
@@ -86,33 +215,31 @@ int main(int argc, char* args[])
 
     }
 
-    #ifdef _WIN32
-      CopyFile(DLL_FILENAME, DLL_FILE_TMP, 0);
-      Sleep(300);
-    #endif
-
-    // initial loading of dll
-    int code_loaded = platform_load_code(&dll);
-    if (!code_loaded) { fprintf(stderr, "Couldn't load dll\n"); exit(-1); }
-    struct stat attr;
-    stat(DLL_FILENAME, &attr);
-    dll.last_mod = attr.st_mtime;
+    // initial loading of dll (NOTE: keeps trying while it is still being built)
+    for (int tries = 0; !platform_load_code(&dll, dll_copies[0]); tries++) {
+        if (tries == 0) { printf("Opening DLL failed. Trying again...\n"); }
+        SDL_Delay(100);
+    }
 
     dll.on_load(&state);
 
+    SDL_Thread* watcher = SDL_CreateThread(watch_dll, "dll watcher", NULL);
+    if (!watcher) { printf("Couldn't start the dll watcher: %s\n", SDL_GetError()); }
+
     int running = 1;
     SDL_Event event;
     int mouse_x, mouse_y;
     float pos_x = 0, pos_y = 0;
     while (running)
     {
-        /* check if dll has changed on disk */
-        if ((stat(DLL_FILENAME, &attr) == 0) && (dll.last_mod != attr.st_mtime))
+        /* swap in the dll the watcher thread loaded, the old one is unloaded once the new code took over */
+        if (SDL_AtomicGet(&dll_ready))
         {
-            printf("Attempting code hot reload...\n");
-            platform_load_code(&dll);
+            void* old_handle = dll.handle;
+            dll = dll_next;
             dll.on_reload(state);
-            dll.last_mod = attr.st_mtime;
+            SDL_UnloadObject(old_handle);
+            SDL_AtomicSet(&dll_ready, 0);
         }
 
         /* event handling */
@@ -0,0 +1,331 @@
+/* replays a trace written with SCOPE_GL_CAPTURE on an EGL context without a window, built once per mode by replay.sh
+ *
+ *   ./replay_shadow trace.bin [repeat]
+ *
+ * Objects are made up for the recorded names: programs that draw nothing visible, 1x1 textures, vertex arrays with
+ * every attribute reading one vertex, framebuffers with a 16x16 color buffer. glDrawElements is replayed as
+ * glDrawArrays of the same count, there is no index data. The lazy build also replays every frame through
+ * scope_glRecord ("sorted") and scope_glDrawBatch ("batched").
+ *
+ * NOTE: the gl* call counts come from SCOPE_GL_STATS, so the timings of every mode include its counters */
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SCOPE_GL_STATS
+#define SCOPE_GL_IMPLEMENTATION
+#include "../scope_gl.h"
+
+#if defined(SCOPE_GL_LAZY_STATE)
+    #define TRACKING "lazy"
+#elif defined(SCOPE_GL_SHADOW_STATE)
+    #define TRACKING "shadow"
+#else
+    #define TRACKING "direct"
+#endif
+#ifdef SCOPE_GL_RESTORE_STATE
+    #define MODE_NAME TRACKING "+restore"
+#else
+    #define MODE_NAME TRACKING "+unset"
+#endif
+
+#define VERT_SOURCE "#version 330\nvoid main() { gl_Position = vec4(0); }"
+#define FRAG_SOURCE "#version 330\nout vec4 color; void main() { color = vec4(1); }"
+
+typedef struct event_t {
+    int    op;                                                               /* SCOPE_GL_OP_* */
+    GLuint args[4];
+} event_t;
+
+typedef struct trace_t {
+    event_t* events;
+    size_t   count;
+    GLuint   frames;
+    GLuint   sites;
+    GLuint   draws;
+    double   captured_ns;                                                    /* between the first and the last event */
+} trace_t;
+
+/* recorded object names to made up ones, open addressing */
+#define MAX_OBJECTS 4096
+enum { PROGRAMS, VERTEX_ARRAYS, TEXTURES, BUFFERS, FRAMEBUFFERS, SAMPLERS, KIND_COUNT };
+typedef struct names_t { GLuint from[MAX_OBJECTS], to[MAX_OBJECTS]; } names_t;
+
+static names_t names[KIND_COUNT];
+static GLuint  default_framebuffer, attrib_buffer, vert_shader, frag_shader;
+
+#ifdef SCOPE_GL_SHADOW_STATE
+static scope_gl_context_t scope_ctx;
+#endif
+#ifdef SCOPE_GL_LAZY_STATE
+static scope_gl_cmdbuf_t cmdbuf;
+static double cmdbuf_memory[1 << 20]; /* NOTE: double for the alignment */
+static scope_gl_batch_t batch;
+#endif
+
+static int load_trace(const char* path, trace_t* t) {
+    FILE* file = fopen(path, "rb");
+    if (!file) { return 0; }
+    fseek(file, 0, SEEK_END);
+    size_t words = (size_t) ftell(file) / 4;
+    fseek(file, 0, SEEK_SET);
+    uint32_t* data = (uint32_t*) malloc(words * 4 + 4);
+    words = fread(data, 4, words, file);
+    fclose(file);
+    if (words < 2 || memcmp(data, "SGLT", 4) != 0 || data[1] != 1) { free(data); return 0; }
+
+    memset(t, 0, sizeof(*t));
+    t->events = (event_t*) calloc(words, sizeof(event_t)); /* NOTE: at least two words per event */
+    for (size_t w = 2; w + 2 <= words; ) {
+        int op = (int) (data[w] & 0xffff);
+        if (op >= SCOPE_GL_OP_COUNT) { fprintf(stderr, "Bad op %d at word %zu\n", op, w); break; }
+        if (op == SCOPE_GL_OP_SITE) { t->sites++; w += 3 + (data[w + 2] + 3) / 4; continue; }
+        if (w + 2 + scope_gl_op_args[op] > words) { break; }
+        event_t* e = &t->events[t->count++];
+        e->op = op;
+        memcpy(e->args, &data[w + 2], scope_gl_op_args[op] * sizeof(uint32_t));
+        if (t->count > 1) { t->captured_ns += data[w + 1]; }
+        t->frames += (op == SCOPE_GL_OP_FRAME);
+        t->draws  += (op == SCOPE_GL_OP_DRAW_ARRAYS || op == SCOPE_GL_OP_DRAW_ELEMENTS);
+        w += 2 + scope_gl_op_args[op];
+    }
+    free(data);
+    return 1;
+}
+
+static GLuint* name_slot(int kind, GLuint name) {
+    names_t* n = &names[kind];
+    for (GLuint i = name * 2654435761u, probe = 0; probe < MAX_OBJECTS; i++, probe++) {
+        GLuint slot = i & (MAX_OBJECTS - 1);
+        if (n->from[slot] == name || n->from[slot] == 0) { n->from[slot] = name; return &n->to[slot]; }
+    }
+    fprintf(stderr, "More than %d objects of a kind\n", MAX_OBJECTS);
+    exit(-1);
+}
+
+static GLuint map_name(int kind, GLuint name) {
+    if (name == 0) { return kind == FRAMEBUFFERS ? default_framebuffer : 0; }
+    return *name_slot(kind, name);
+}
+
+static GLuint create_framebuffer(void) {
+    GLuint fbo, rbo;
+    glGenFramebuffers(1, &fbo);
+    glGenRenderbuffers(1, &rbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, 16, 16);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return fbo;
+}
+
+/* attribute format with a stride of 0, so every vertex reads the same 16 bytes */
+static GLuint create_vertex_array(void) {
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    for (GLuint a = 0; a < SCOPE_GL_MAX_VERTEX_ATTRIBS; a++) { glVertexAttribFormat(a, 4, GL_FLOAT, GL_FALSE, 0); glVertexAttribBinding(a, 0); }
+    glBindVertexBuffer(0, attrib_buffer, 0, 0);
+    glBindVertexArray(0);
+    return vao;
+}
+
+static GLuint create_object(int kind, GLuint target) {
+    GLuint id = 0;
+    switch (kind) {
+        case PROGRAMS:
+            id = glCreateProgram();
+            glAttachShader(id, vert_shader);
+            glAttachShader(id, frag_shader);
+            glLinkProgram(id);
+            break;
+        case VERTEX_ARRAYS: id = create_vertex_array(); break;
+        case TEXTURES:
+            glGenTextures(1, &id);
+            glBindTexture(target, id);
+            if (target == GL_TEXTURE_2D) { glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, 1, 1); }
+            glBindTexture(target, 0);
+            break;
+        case BUFFERS:
+            glGenBuffers(1, &id);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+            glBufferData(GL_COPY_WRITE_BUFFER, 256, NULL, GL_STATIC_DRAW);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            break;
+        case FRAMEBUFFERS: id = create_framebuffer(); break;
+        case SAMPLERS:     glGenSamplers(1, &id); break;
+    }
+    return id;
+}
+
+/* before the scopes track anything, so the objects are made with plain gl* calls */
+static void create_objects(const trace_t* t) {
+    const char* vert_source = VERT_SOURCE;
+    const char* frag_source = FRAG_SOURCE;
+    vert_shader = glCreateShader(GL_VERTEX_SHADER);
+    frag_shader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(vert_shader, 1, &vert_source, NULL); glCompileShader(vert_shader);
+    glShaderSource(frag_shader, 1, &frag_source, NULL); glCompileShader(frag_shader);
+    glGenBuffers(1, &attrib_buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, attrib_buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, 16, NULL, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    for (size_t i = 0; i < t->count; i++) {
+        const event_t* e = &t->events[i];
+        int kind = -1; GLuint name = 0, target = 0;
+        switch (e->op) {
+            case SCOPE_GL_OP_USE_PROGRAM:       kind = PROGRAMS;      name = e->args[0]; break;
+            case SCOPE_GL_OP_BIND_VERTEX_ARRAY: kind = VERTEX_ARRAYS; name = e->args[0]; break;
+            case SCOPE_GL_OP_BIND_TEXTURE:      kind = TEXTURES;      name = e->args[1]; target = e->args[0]; break;
+            case SCOPE_GL_OP_BIND_BUFFER:       kind = BUFFERS;       name = e->args[1]; break;
+            case SCOPE_GL_OP_BIND_FRAMEBUFFER:  kind = FRAMEBUFFERS;  name = e->args[1]; break;
+            case SCOPE_GL_OP_BIND_SAMPLER:      kind = SAMPLERS;      name = e->args[1]; break;
+        }
+        if (kind < 0 || name == 0) { continue; }
+        GLuint* slot = name_slot(kind, name);
+        if (*slot == 0) { *slot = create_object(kind, target); }
+    }
+}
+
+static size_t replay_event(const trace_t* t, size_t i);
+
+/* up to and including the pop of the enclosing scope */
+static size_t replay_scope(const trace_t* t, size_t i) {
+    while (i < t->count && t->events[i].op != SCOPE_GL_OP_POP && t->events[i].op != SCOPE_GL_OP_FRAME) { i = replay_event(t, i); }
+    return (i < t->count && t->events[i].op == SCOPE_GL_OP_POP) ? i + 1 : i;
+}
+
+static GLfloat float_arg(GLuint bits) { GLfloat f; memcpy(&f, &bits, sizeof(f)); return f; }
+
+static size_t replay_event(const trace_t* t, size_t i) {
+    const GLuint* a = t->events[i].args;
+    switch (t->events[i].op) {
+        case SCOPE_GL_OP_DRAW_ARRAYS:        scope_glDrawArrays(a[0], (GLint) a[1], (GLsizei) a[2]); break;
+        case SCOPE_GL_OP_DRAW_ELEMENTS:      scope_glDrawArrays(a[0], 0, (GLsizei) a[1]); break;
+        case SCOPE_GL_OP_CLEAR:              scope_glClear(a[0]); break;
+        case SCOPE_GL_OP_USE_PROGRAM:        scope_glUseProgram(map_name(PROGRAMS, a[0]))                    { i = replay_scope(t, i + 1); } return i;
+        case SCOPE_GL_OP_BIND_VERTEX_ARRAY:  scope_glBindVertexArray(map_name(VERTEX_ARRAYS, a[0]))          { i = replay_scope(t, i + 1); } return i;
+        case SCOPE_GL_OP_BIND_TEXTURE:       scope_glBindTexture(a[0], map_name(TEXTURES, a[1]))             { i = replay_scope(t, i + 1); } return i;
+        case SCOPE_GL_OP_BIND_BUFFER:        scope_glBindBuffer(a[0], map_name(BUFFERS, a[1]))               { i = replay_scope(t, i + 1); } return i;
+        case SCOPE_GL_OP_ENABLE:             scope_glEnable(a[0])                                            { i = replay_scope(t, i + 1); } return i;
+        case SCOPE_GL_OP_DISABLE:            scope_glDisable(a[0])                                           { i = replay_scope(t, i + 1); } return i;
+        case SCOPE_GL_OP_BIND_FRAMEBUFFER:   scope_glBindFramebuffer(a[0], map_name(FRAMEBUFFERS, a[1]))     { i = replay_scope(t, i + 1); } return i;
+        case SCOPE_GL_OP_VIEWPORT:           scope_glViewport((GLint) a[0], (GLint) a[1], (GLsizei) a[2], (GLsizei) a[3]) { i = replay_scope(t, i + 1); } return i;
+        case SCOPE_GL_OP_SCISSOR:            scope_glScissor((GLint) a[0], (GLint) a[1], (GLsizei) a[2], (GLsizei) a[3])  { i = replay_scope(t, i + 1); } return i;
+        case SCOPE_GL_OP_CLEAR_COLOR:        scope_glClearColor(float_arg(a[0]), float_arg(a[1]), float_arg(a[2]), float_arg(a[3])) { i = replay_scope(t, i + 1); } return i;
+        case SCOPE_GL_OP_BLEND_FUNC:         scope_glBlendFunc(a[0], a[1])                                   { i = replay_scope(t, i + 1); } return i;
+        case SCOPE_GL_OP_BLEND_EQUATION:     scope_glBlendEquation(a[0])                                     { i = replay_scope(t, i + 1); } return i;
+        case SCOPE_GL_OP_CULL_FACE:          scope_glCullFace(a[0])                                          { i = replay_scope(t, i + 1); } return i;
+        case SCOPE_GL_OP_FRONT_FACE:         scope_glFrontFace(a[0])                                         { i = replay_scope(t, i + 1); } return i;
+        case SCOPE_GL_OP_BIND_SAMPLER:       scope_glBindSampler(a[0], map_name(SAMPLERS, a[1]))             { i = replay_scope(t, i + 1); } return i;
+        case SCOPE_GL_OP_ACTIVE_TEXTURE:     scope_glActiveTexture(a[0])                                     { i = replay_scope(t, i + 1); } return i;
+        case SCOPE_GL_OP_VERTEX_ATTRIB_MASK: scope_glVertexAttribMask(a[0] & ((1u << SCOPE_GL_MAX_VERTEX_ATTRIBS) - 1)) { i = replay_scope(t, i + 1); } return i;
+    }
+    return i + 1; /* NOTE: also skips pops without a push, of scopes entered before the capture started */
+}
+
+/* index of the next frame */
+static size_t replay_frame(const trace_t* t, size_t i) {
+    while (i < t->count && t->events[i].op != SCOPE_GL_OP_FRAME) { i = replay_event(t, i); }
+    return i + 1;
+}
+
+#ifdef SCOPE_GL_LAZY_STATE
+static size_t replay_frame_sorted(const trace_t* t, size_t i) {
+    scope_glRecord(&cmdbuf) { i = replay_frame(t, i); }
+    scope_gl_cmdbuf_submit(&cmdbuf);
+    return i;
+}
+
+static size_t replay_frame_batched(const trace_t* t, size_t i) {
+    scope_glDrawBatch(&batch) { i = replay_frame(t, i); }
+    scope_gl_batch_frame(&batch);
+    return i;
+}
+#endif
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void run(const trace_t* t, int repeat, const char* name, size_t (*frame)(const trace_t*, size_t)) {
+    for (size_t i = 0; i < t->count; ) { i = frame(t, i); } /* warm up caches and the driver */
+    glFinish();
+
+    scope_gl_stats_reset();
+    double elapsed = 0;
+    GLuint frames = 0;
+    for (int r = 0; r < repeat; r++) {
+        for (size_t i = 0; i < t->count; frames++) {
+            double start = now_ns();
+            i = frame(t, i);
+            scope_glFlushState();
+            elapsed += now_ns() - start;
+            glFinish(); /* NOTE: not timed */
+        }
+    }
+    scope_gl_stats_t stats = scope_gl_stats_snapshot();
+
+    GLuint sets = 0, skipped = 0, queries = 0;
+    for (int k = 0; k < SCOPE_GL_STAT_COUNT; k++) { sets += stats.sets[k]; skipped += stats.skipped[k]; queries += stats.queries[k]; }
+    double draws = (double) t->draws * repeat / (frames ? frames : 1);
+    printf("%-16s %-10s %12.0f ns/frame %10.1f calls/frame %10.1f queries/frame %10.1f skipped/frame\n",
+           MODE_NAME, name, elapsed / frames, (sets + queries) / (double) frames + draws, queries / (double) frames, skipped / (double) frames);
+
+    GLuint errors = 0;
+    while (glGetError() != GL_NO_ERROR && errors < 1000) { errors++; }
+    if (errors) { fprintf(stderr, "%u GL errors in %s, the trace may use objects in ways the made up ones do not support\n", errors, name); }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) { fprintf(stderr, "usage: %s trace.bin [repeat]\n", argv[0]); return -1; }
+    int repeat = (argc > 2) ? atoi(argv[2]) : 10;
+    trace_t trace;
+    if (!load_trace(argv[1], &trace)) { fprintf(stderr, "Couldn't read trace %s\n", argv[1]); return -1; }
+
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (!get_platform_display) { fprintf(stderr, "EGL_EXT_platform_base missing\n"); return -1; }
+    EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (!eglInitialize(display, NULL, NULL) || !eglBindAPI(EGL_OPENGL_API)) { fprintf(stderr, "Couldn't initialize EGL\n"); return -1; }
+    EGLint attribs[] = { EGL_CONTEXT_MAJOR_VERSION, 4, EGL_CONTEXT_MINOR_VERSION, 5,
+                         EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE };
+    EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attribs);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) { fprintf(stderr, "Couldn't create GL context\n"); return -1; }
+
+    /* surfaceless contexts have no default framebuffer, framebuffer 0 of the trace is this one */
+    default_framebuffer = create_framebuffer();
+    create_objects(&trace);
+    glBindFramebuffer(GL_FRAMEBUFFER, default_framebuffer);
+    glViewport(0, 0, 16, 16);
+    glEnable(GL_RASTERIZER_DISCARD); /* only the cpu side is measured */
+    printf("%s: %u frames, %zu events, %u sites, %u draws, %.0f ns/frame when captured\n",
+           argv[1], trace.frames, trace.count, trace.sites, trace.draws / (trace.frames ? trace.frames : 1), trace.captured_ns / (trace.frames ? trace.frames : 1));
+
+#ifdef SCOPE_GL_SHADOW_STATE
+    scope_gl_context_sync(&scope_ctx);
+    scope_gl_make_current(&scope_ctx);
+#endif
+#ifdef SCOPE_GL_LAZY_STATE
+    scope_gl_cmdbuf_init(&cmdbuf, cmdbuf_memory, sizeof(cmdbuf_memory));
+    scope_gl_batch_init(&batch, 1 << 20);
+#endif
+
+    run(&trace, repeat, "replay",  replay_frame);
+#ifdef SCOPE_GL_LAZY_STATE
+    run(&trace, repeat, "sorted",  replay_frame_sorted);
+    run(&trace, repeat, "batched", replay_frame_batched);
+#endif
+    return 0;
+}
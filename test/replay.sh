@@ -0,0 +1,19 @@
+#!/bin/bash
+# build the trace replay for every mode and run it on a trace from SCOPE_GL_CAPTURE: ./replay.sh trace.bin [repeat]
+set -e
+
+CC=${CC:-clang}
+modes=("unset"          ""
+       "restore"        "-DSCOPE_GL_RESTORE_STATE"
+       "shadow"         "-DSCOPE_GL_SHADOW_STATE"
+       "shadow_restore" "-DSCOPE_GL_SHADOW_STATE -DSCOPE_GL_RESTORE_STATE"
+       "lazy"           "-DSCOPE_GL_LAZY_STATE"
+       "lazy_restore"   "-DSCOPE_GL_LAZY_STATE -DSCOPE_GL_RESTORE_STATE")
+
+for ((i = 0; i < ${#modes[@]}; i += 2)); do
+    $CC -O2 ${modes[i+1]} replay.c -o ./replay_${modes[i]} -lEGL -lGL
+done
+
+for ((i = 0; i < ${#modes[@]}; i += 2)); do
+    ./replay_${modes[i]} "$@"
+done